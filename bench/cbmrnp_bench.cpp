@@ -0,0 +1,397 @@
+/*
+ * Benchmark of the hot paths of the spacetime sheet:
+ *  - potential:      Binary::potential(), one point at a time on one thread
+ *  - potentialBatch: Binary::potentialBatch() over the whole grid on one thread
+ *  - fieldQuery:     FieldQuery::evaluate() with gradient over the grid points
+ *                    in random order, cold, on the thread pool
+ *  - calcPositions:  the heights of the grid on the thread pool, warm started
+ *                    from the previous frame as in the running program
+ *  - derivatives:    calcPositions with the exact normals and curvature
+ *                    from dual numbers, as for the streamed path
+ *  - keyframed:      the keyframed path at 60 Hz, a full grid every
+ *                    Spacetime::keyframeInterval, per frame
+ *  - createObject:   building and uploading the grid buffers, needs an
+ *                    OpenGL 4.0 context (run with QT_QPA_PLATFORM=offscreen
+ *                    on machines without a display)
+ * for a sweep of grid resolutions and binary parameters.
+ *
+ * usage: cbmrnp_bench [--repetitions N] [--nside 50,100,...] [--output file.json]
+ *
+ * The results are written as JSON: per benchmark, parameter set and nside
+ * the percentiles of the time per vertex and the throughput.
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+
+#include "objects/spacetime.h"
+#include "physics/fieldquery.h"
+#include "physics/isa.h"
+
+namespace {
+
+/**
+ * @brief The BenchSpacetime class exposes the stages of Spacetime::produceFrame() one by one
+ */
+class BenchSpacetime : public Spacetime
+{
+public:
+    void configure(int side, const BinaryParameters& parameters)
+    {
+        nside = side;
+        simSide = side;
+        time = 3.7f;
+        binary.setParameters(parameters);
+        binary.setFarFieldTolerance(farFieldTolerance);
+
+        // start from cold, then one frame so the retarded time caches are warm
+        positions.clear();
+        calcPositions(false);
+    }
+
+    void nextFrame() { time += 1.f/60.f; }
+
+    void heights() { calcPositions(false); }
+
+    void derivatives() { calcPositions(true); }
+
+    void keyframed(SpacetimeFrame& frame) { nextFrame(); keyframeFrame(frame); }
+
+    void upload() { buildGrid(simSide); }
+
+    const Binary& physics() const { return binary; }
+    float frameTime() const { return time; }
+    unsigned int threads() const { return pool->size(); }
+};
+
+/**
+ * @brief The ParameterSet struct is one point of the binary parameter sweep
+ */
+struct ParameterSet
+{
+    std::string name;
+    BinaryParameters parameters;
+};
+
+std::vector<ParameterSet> parameterSweep()
+{
+    std::vector<ParameterSet> sets;
+
+    sets.push_back({"default", BinaryParameters()});
+
+    BinaryParameters slow;
+    slow.c_light_fraction = 0.5f;
+    sets.push_back({"slow", slow});
+
+    BinaryParameters fast;
+    fast.c_light_fraction = 0.9f;
+    sets.push_back({"fast", fast});
+
+    // body 1 with a third of the mass of body 0
+    BinaryParameters unequal;
+    unequal.R_N1 = 0.014f;
+    sets.push_back({"unequal", unequal});
+
+    // the other potential profiles, each has its own instantiation of the potential loop
+    BinaryParameters softened;
+    softened.model = eModelSoftened;
+    sets.push_back({"softened", softened});
+
+    BinaryParameters yukawa;
+    yukawa.model = eModelYukawa;
+    sets.push_back({"yukawa", yukawa});
+
+    return sets;
+}
+
+/**
+ * @brief The Result struct holds the timings of one benchmark run in ns per vertex
+ */
+struct Result
+{
+    std::string benchmark;
+    std::string parameterSet;
+    BinaryParameters parameters;
+    int nside;
+    long long vertices;
+    std::vector<double> ns;     /**< per repetition, sorted */
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    // nearest rank
+    size_t rank = size_t(p/100.*sorted.size() + 0.5);
+    rank = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+    return sorted[rank];
+}
+
+/**
+ * @brief measure runs func repetitions times after one warm-up run
+ * @param before called untimed before every run
+ */
+template<class F, class B>
+std::vector<double> measure(F func, B before, long long vertices, int repetitions)
+{
+    std::vector<double> ns;
+    for(int r = -1; r < repetitions; ++r)
+    {
+        before();
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto stop = std::chrono::steady_clock::now();
+        if(r >= 0)
+            ns.push_back(std::chrono::duration<double, std::nano>(stop - start).count()/vertices);
+    }
+    std::sort(ns.begin(), ns.end());
+    return ns;
+}
+
+bool parsePositive(const std::string& text, int& value)
+{
+    // the whole argument has to be a whole number above 0, "0", "foo" or "50x" are rejected
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(begin, &end, 10);
+    if(end == begin || *end != '\0' || errno == ERANGE || parsed <= 0 || parsed > INT_MAX)
+        return false;
+
+    value = int(parsed);
+    return true;
+}
+
+bool parseList(const std::string& list, std::vector<int>& values)
+{
+    values.clear();
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ','))
+    {
+        int value;
+        if(!parsePositive(item, value))
+            return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, int repetitions, unsigned int threads,
+               float farFieldTolerance, const std::string& renderer)
+{
+    out << "{\n";
+    out << "  \"isa\": \"" << simdIsaName(simdIsa()) << "\",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"repetitions\": " << repetitions << ",\n";
+    out << "  \"farFieldTolerance\": " << farFieldTolerance << ",\n";
+    out << "  \"renderer\": \"" << renderer << "\",\n";
+    out << "  \"results\": [\n";
+
+    for(size_t k = 0; k < results.size(); ++k)
+    {
+        const Result& result = results[k];
+        const BinaryParameters& p = result.parameters;
+
+        double sum = 0.;
+        for(double ns : result.ns)
+            sum += ns;
+        double median = percentile(result.ns, 50.);
+
+        out << "    {\"benchmark\": \"" << result.benchmark << "\""
+            << ", \"parameters\": \"" << result.parameterSet << "\""
+            << ", \"c_light_fraction\": " << p.c_light_fraction
+            << ", \"R_N0\": " << p.R_N0 << ", \"R_N1\": " << p.R_N1
+            << ", \"model\": \"" << potentialModelName(p.model) << "\""
+            << ", \"nside\": " << result.nside
+            << ", \"vertices\": " << result.vertices
+            << ",\n     \"ns_per_vertex\": {\"min\": " << result.ns.front()
+            << ", \"p50\": " << median
+            << ", \"p90\": " << percentile(result.ns, 90.)
+            << ", \"p99\": " << percentile(result.ns, 99.)
+            << ", \"max\": " << result.ns.back()
+            << ", \"mean\": " << sum/result.ns.size() << "}"
+            << ",\n     \"ms_p50\": " << median*result.vertices*1e-6
+            << ", \"mvertices_per_second\": " << 1e3/median << "}"
+            << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    int repetitions = 21;
+    std::vector<int> sides = {50, 100, 150, 250, 400};
+    std::string output;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--repetitions" && i + 1 < argc && parsePositive(argv[i + 1], repetitions))
+            ++i;
+        else if(arg == "--nside" && i + 1 < argc && parseList(argv[i + 1], sides))
+            ++i;
+        else if(arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--repetitions N] [--nside 50,100,...] [--output file.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    QGuiApplication app(argc, argv);
+
+    BenchSpacetime spacetime;
+    FieldQuery query;
+    std::vector<Result> results;
+    auto nothing = [](){};
+
+    for(const ParameterSet& set : parameterSweep())
+    {
+        for(int side : sides)
+        {
+            spacetime.configure(side, set.parameters);
+            const Binary& binary = spacetime.physics();
+
+            long long vertices = (side + 1)*(side + 1);
+            std::vector<float> x(vertices), z(vertices), potential(vertices);
+            for(int j = 0; j < side + 1; ++j)
+                for(int i = 0; i < side + 1; ++i)
+                {
+                    x[i + j*(side + 1)] = -1 + 2*float(i)/float(side);
+                    z[i + j*(side + 1)] = -1 + 2*float(j)/float(side);
+                }
+
+            float time = spacetime.frameTime();
+            results.push_back({"potential", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                for(long long k = 0; k < vertices; ++k)
+                    potential[k] = binary.potential(time, x[k], z[k]);
+            }, nothing, vertices, repetitions)});
+
+            results.push_back({"potentialBatch", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                binary.potentialBatch(time, x.data(), z.data(), potential.data(), vertices);
+            }, nothing, vertices, repetitions)});
+
+            // the probes of an external tool: unordered points at one time, no warm start
+            std::vector<float> px(x), pz(z), pt(vertices, time), gradientX(vertices), gradientZ(vertices);
+            std::mt19937 rng(42);
+            std::vector<long long> shuffle(vertices);
+            std::iota(shuffle.begin(), shuffle.end(), 0ll);
+            std::shuffle(shuffle.begin(), shuffle.end(), rng);
+            for(long long k = 0; k < vertices; ++k)
+            {
+                px[k] = x[shuffle[k]];
+                pz[k] = z[shuffle[k]];
+            }
+            query.setParameters(set.parameters);
+            query.binary().setFarFieldTolerance(binary.getFarFieldTolerance());
+            results.push_back({"fieldQuery", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                query.evaluate(px.data(), pz.data(), pt.data(), vertices, potential.data(), gradientX.data(), gradientZ.data());
+            }, nothing, vertices, repetitions)});
+
+            results.push_back({"calcPositions", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                spacetime.heights();
+            }, [&](){ spacetime.nextFrame(); }, vertices, repetitions)});
+
+            results.push_back({"derivatives", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                spacetime.derivatives();
+            }, [&](){ spacetime.nextFrame(); }, vertices, repetitions)});
+
+            // one keyframe interval of 60 Hz frames, the time is per frame
+            int keyframeFrames = int(std::lround(Spacetime::keyframeInterval*60.f));
+            SpacetimeFrame frame;
+            results.push_back({"keyframed", set.name, set.parameters, side, vertices, measure([&]()
+            {
+                for(int f = 0; f < keyframeFrames; ++f)
+                    spacetime.keyframed(frame);
+            }, nothing, keyframeFrames*vertices, repetitions)});
+        }
+    }
+
+    // the upload does not depend on the binary, only on nside
+    std::string renderer = "none";
+    QSurfaceFormat format;
+    format.setVersion(4, 0);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if(context.create() && context.makeCurrent(&surface))
+    {
+        glewExperimental = GL_TRUE; // otherwise some function pointers are NULL...
+        GLenum err = glewInit();
+        glGetError(); // clear a gl error produced by glewInit
+
+        if(err == GLEW_OK)
+        {
+            renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+            for(int side : sides)
+            {
+                spacetime.configure(side, BinaryParameters());
+                long long vertices = (side + 1)*(side + 1);
+
+                // glFinish so the time includes the transfer, not only queuing it
+                results.push_back({"createObject", "default", BinaryParameters(), side, vertices, measure([&]()
+                {
+                    spacetime.upload();
+                    glFinish();
+                }, nothing, vertices, repetitions)});
+            }
+        }
+        else
+        {
+            std::cerr << "createObject skipped, glewInit failed: " << glewGetErrorString(err) << std::endl;
+        }
+
+        context.doneCurrent();
+    }
+    else
+    {
+        std::cerr << "createObject skipped, no OpenGL 4.0 core context" << std::endl;
+    }
+
+    float tolerance = spacetime.physics().getFarFieldTolerance();
+    if(output.empty())
+    {
+        writeJson(std::cout, results, repetitions, spacetime.threads(), tolerance, renderer);
+    }
+    else
+    {
+        std::ofstream file(output);
+        writeJson(file, results, repetitions, spacetime.threads(), tolerance, renderer);
+        std::cerr << "wrote " << results.size() << " results to " << output << std::endl;
+    }
+
+    return 0;
+}
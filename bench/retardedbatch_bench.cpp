@@ -0,0 +1,174 @@
+/*
+ * Micro-benchmark: batch retarded time solver against the scalar path
+ * of Binary::retardedDistance() for the default binary parameters.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "physics/retardedbatch.h"
+
+namespace {
+
+// the scalar path as in Binary::helperfunction/ddt_helpfunc/retardedDistance
+struct ScalarPath
+{
+    float rho, omega, phase, c_light, c_light_fraction;
+
+    float helperfunction(float delta_t, float x, float z) const
+    {
+        float phi = phase - omega*delta_t;
+        return c_light_fraction*std::sqrt(x*x + z*z + rho*rho - 2*rho*(x*std::sin(phi) + z*std::cos(phi))) - rho*omega*delta_t;
+    }
+
+    float ddt_helpfunc(float delta_t, float x, float z) const
+    {
+        float phi = phase - omega*delta_t;
+        float result = c_light_fraction*rho*omega*(x*std::cos(phi) - z*std::sin(phi));
+        result /= std::sqrt(x*x + z*z + rho*rho - 2*rho*(x*std::sin(phi) + z*std::cos(phi)));
+        return result - rho*omega;
+    }
+
+    float retardedDistance(float x, float z, int iterations, float tolerance) const
+    {
+        float toDeltaT = c_light_fraction/(rho*omega);
+        float r = std::sqrt(x*x + z*z);
+        float lo = std::abs(r - rho)*toDeltaT;
+        float hi = (r + rho)*toDeltaT;
+
+        float dx = x - rho*std::sin(phase);
+        float dz = z - rho*std::cos(phase);
+        float delta_t = std::sqrt(dx*dx + dz*dz)*toDeltaT;
+
+        for(int i = 0; i < iterations; ++i)
+        {
+            float h = helperfunction(delta_t, x, z);
+            if(std::abs(h) <= tolerance)
+                break;
+
+            if(h > 0)
+                lo = delta_t;
+            else
+                hi = delta_t;
+
+            float next = delta_t - h/ddt_helpfunc(delta_t, x, z);
+            delta_t = (next > lo && next < hi) ? next : 0.5f*(lo + hi);
+        }
+
+        float phi = phase - omega*delta_t;
+        float rx = x - rho*std::sin(phi);
+        float rz = z - rho*std::cos(phi);
+        return std::sqrt(rx*rx + rz*rz);
+    }
+};
+
+void printHistograms(const char* name, const RetardedStats& stats)
+{
+    std::cout << name << " steps:";
+    for(int bin = 0; bin < RetardedStats::iterationBins; ++bin)
+        std::cout << " " << stats.iterationHistogram[bin];
+    std::cout << std::endl << name << " residuals (<1e-9 ... >=1e-3):";
+    for(int bin = 0; bin < RetardedStats::residualBins; ++bin)
+        std::cout << " " << stats.residualHistogram[bin];
+    std::cout << std::endl;
+}
+
+template<class F>
+double nsPerPoint(F func, int points, int repetitions)
+{
+    std::vector<double> runs;
+    for(int r = 0; r < repetitions; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto stop = std::chrono::steady_clock::now();
+        runs.push_back(std::chrono::duration<double, std::nano>(stop - start).count()/points);
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs[runs.size()/2];
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    int points = argc > 1 ? std::atoi(argv[1]) : 151*151;
+    int repetitions = 21;
+
+    // default BinaryParameters
+    float separation = 0.1f;
+    float omega = 4*(3.14159265359f*0.5f)/15.f;
+    float c_light_fraction = 0.8f;
+    float time = 3.7f;
+
+    RetardedOrbit orbit;
+    orbit.rho = 0.5f*separation;
+    orbit.phase = std::fmod(omega*time, 2*3.14159265359f);
+    orbit.omega = omega;
+    orbit.c_light_fraction = c_light_fraction;
+    orbit.c_light = omega*separation/(2*c_light_fraction);
+    orbit.iterations = 16;
+    orbit.tolerance = 1e-6f;
+
+    ScalarPath scalar = { orbit.rho, orbit.omega, orbit.phase, orbit.c_light, orbit.c_light_fraction };
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::vector<float> x(points), z(points), reference(points), batch(points);
+    for(int k = 0; k < points; ++k)
+    {
+        x[k] = uniform(rng);
+        z[k] = uniform(rng);
+    }
+
+    double scalarNs = nsPerPoint([&]()
+    {
+        for(int k = 0; k < points; ++k)
+            reference[k] = scalar.retardedDistance(x[k], z[k], orbit.iterations, orbit.tolerance);
+    }, points, repetitions);
+
+    double batchNs = nsPerPoint([&]()
+    {
+        retardedDistanceBatch(orbit, x.data(), z.data(), batch.data(), points);
+    }, points, repetitions);
+
+    // warm start from the solution of the previous frame (18 ms earlier)
+    RetardedOrbit previous = orbit;
+    previous.phase -= omega*0.018f;
+    std::vector<float> previousDeltaT(points, -1.f), deltaT(points), warm(points);
+    RetardedStats coldStats, warmStats;
+    retardedDistanceBatch(previous, x.data(), z.data(), warm.data(), points, previousDeltaT.data(), &coldStats);
+
+    double warmNs = nsPerPoint([&]()
+    {
+        deltaT = previousDeltaT;
+        warmStats = RetardedStats();
+        retardedDistanceBatch(orbit, x.data(), z.data(), warm.data(), points, deltaT.data(), &warmStats);
+    }, points, repetitions);
+
+    float maxDeviation = 0.f;
+    for(int k = 0; k < points; ++k)
+        maxDeviation = std::max(maxDeviation, std::max(std::abs(reference[k] - batch[k]), std::abs(reference[k] - warm[k])));
+
+    std::cout << "points:          " << points << std::endl;
+    std::cout << "scalar:          " << scalarNs << " ns/point" << std::endl;
+    std::cout << "batch (" << retardedBatchIsa() << "): " << batchNs << " ns/point" << std::endl;
+    std::cout << "batch warm:      " << warmNs << " ns/point" << std::endl;
+    std::cout << "speedup:         " << scalarNs/batchNs << " (cold), " << scalarNs/warmNs << " (warm)" << std::endl;
+    std::cout << "newton steps:    " << double(coldStats.newtonSteps)/coldStats.points << "/point (cold), "
+              << double(warmStats.newtonSteps)/warmStats.points << "/point (warm, "
+              << warmStats.warmStarts << " of " << warmStats.points << " started from the guess)" << std::endl;
+    std::cout << "worst case:      " << std::max(coldStats.maxIterations(), warmStats.maxIterations()) << " steps, "
+              << coldStats.capped + warmStats.capped << " points capped, "
+              << coldStats.bisections + warmStats.bisections << " bisections" << std::endl;
+    printHistograms("cold", coldStats);
+    printHistograms("warm", warmStats);
+    std::cout << "max deviation:   " << maxDeviation << std::endl;
+
+    return 0;
+}
@@ -1,7 +1,9 @@
 #include "gui/cli.h"
 
 cli::cli(int uargc, char* uargv[])
-    : action(eNoAction)
+    : benchmarkFrames(0)
+    , frameRate(-1.f)
+    , action(eNoAction)
     , stopFlag(false)
 {
     readCommandLineArguments(uargc, uargv);
@@ -12,6 +14,8 @@ cli::cli(int uargc, char* uargv[])
     if((action & ePrintREADME) == ePrintREADME) printREADME();
     if((action & eOverrideConfig) == eOverrideConfig) overrideConfig();
     if((action & eSetStopFlag) == eSetStopFlag) setStopFlag();
+    if((action & eRunBenchmark) == eRunBenchmark) setBenchmark();
+    if((action & eSetFrameRate) == eSetFrameRate) setFrameRate();
 }
 
 cli::~cli() {};
@@ -22,6 +26,12 @@ cli::continueRun() { return !stopFlag; }
 std::string
 cli::getConfigFile() { return configFile; }
 
+int
+cli::getBenchmarkFrames() { return benchmarkFrames; }
+
+float
+cli::getFrameRate() { return frameRate; }
+
 bool
 cli::checkFile()
 {
@@ -35,6 +45,42 @@ cli::checkFile()
     return fileok;
 }
 
+bool
+cli::parseFrameRate(float& rate) const
+{
+    // negative means vsync
+    if(argv[2] == "vsync")
+    {
+        rate = -1.f;
+        return true;
+    }
+
+    // the whole argument has to be a number, "60Hz" or "foo" are rejected
+    const char* begin = argv[2].c_str();
+    char* end = nullptr;
+    float value = std::strtof(begin, &end);
+    if(end == begin || *end != '\0' || !std::isfinite(value) || value < 0.f)
+        return false;
+
+    rate = value;
+    return true;
+}
+
+bool
+cli::parseBenchmarkFrames(int& frames) const
+{
+    // a whole positive number, "10abc" or "1e3" are rejected
+    const char* begin = argv[2].c_str();
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(begin, &end, 10);
+    if(end == begin || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+        return false;
+
+    frames = int(value);
+    return true;
+}
+
 void
 cli::readCommandLineArguments(int uargc, char* uargv[])
 {
@@ -62,6 +108,10 @@ cli::evaluateCommandLineArguments()
 	    action = action | ePrintUsage;
 	    action = action | eSetStopFlag;
 	}
+	else if(argv[1] == "--benchmark")
+	{
+	    action = action | eRunBenchmark;
+	}
 	else
 	{
 	    action = action | ePrintUsage;
@@ -81,6 +131,14 @@ cli::evaluateCommandLineArguments()
 		action = action | eOverrideConfig;
 	    }
 	}
+	else if(argv[1] == "--benchmark" && parseBenchmarkFrames(benchmarkFrames))
+	{
+	    action = action | eRunBenchmark;
+	}
+	else if(argv[1] == "--fps" && parseFrameRate(frameRate))
+	{
+	    action = action | eSetFrameRate;
+	}
 	else
 	{
 	    action = action | ePrintUsage;
@@ -109,6 +167,15 @@ cli::printUsage()
     std::cout << "                        show this message." << std::endl;
     std::cout << "  --help" << std::endl;
     std::cout << "                        shows the instructions from the README file" << std::endl;
+    std::cout << "  --benchmark [frames]" << std::endl;
+    std::cout << "                        renders <frames> frames (default 1000) along a" << std::endl;
+    std::cout << "                        scripted camera path with a fixed timestep and" << std::endl;
+    std::cout << "                        without vsync, prints the CPU, GPU and frame" << std::endl;
+    std::cout << "                        times and exits" << std::endl;
+    std::cout << "  --fps <rate>" << std::endl;
+    std::cout << "                        paces the frames: 'vsync' (default) waits for" << std::endl;
+    std::cout << "                        the display, 0 renders as fast as possible and" << std::endl;
+    std::cout << "                        any other <rate> caps the frames per second" << std::endl;
     std::cout << std::endl;
 }
 
@@ -147,3 +214,16 @@ cli::setStopFlag()
 {
     stopFlag = true;
 }
+
+void
+cli::setBenchmark()
+{
+    if(argc != 3 || !parseBenchmarkFrames(benchmarkFrames))
+        benchmarkFrames = 1000;
+}
+
+void
+cli::setFrameRate()
+{
+    parseFrameRate(frameRate);
+}
@@ -3,6 +3,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -18,7 +22,9 @@ enum eAction
     ePrintBadFile   = (1 << 1),
     ePrintREADME    = (1 << 2),
     eOverrideConfig = (1 << 3),
-    eSetStopFlag    = (1 << 4)
+    eSetStopFlag    = (1 << 4),
+    eRunBenchmark   = (1 << 5),
+    eSetFrameRate   = (1 << 6)
 };
 
 class cli
@@ -29,15 +35,21 @@ public:
 
     bool continueRun();
     std::string getConfigFile();
+    int getBenchmarkFrames();
+    float getFrameRate();
 
 private:
     int argc;
     std::vector<std::string> argv;
     std::string configFile;
+    int benchmarkFrames;
+    float frameRate;
     int action;
     bool stopFlag;
     
     bool checkFile();
+    bool parseFrameRate(float& rate) const;
+    bool parseBenchmarkFrames(int& frames) const;
     void readCommandLineArguments(int uargc, char* uargv[]);
     void evaluateCommandLineArguments();
     void printUsage();
@@ -45,6 +57,8 @@ private:
     void printREADME();
     void overrideConfig();
     void setStopFlag();
+    void setBenchmark();
+    void setFrameRate();
 };
 
 #endif
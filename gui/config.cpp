@@ -0,0 +1,4 @@
+#include "gui/config.h"
+
+bool Config::isPlaying = true;
+float Config::pauseTime = 0.f;
@@ -1,20 +1,30 @@
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <GL/glew.h>
 
 #include "gui/glwidget.hpp"
 
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
 #include <QMouseEvent>
+#include <QKeyEvent>
 
 #define GLM_FORCE_RADIANS
 #define GLM_SWIZZLE
 #include <glm/gtx/transform.hpp>
 
 #include "gui/config.h"
+#include "gui/gputrace.h"
+#include "util/trace.h"
 
 #include "objects/spacetime.h"
 #include "objects/skybox.h"
 #include "objects/planet.h"
+#include "objects/simulation.h"
+#include "objects/hud.h"
+#include "objects/upscaler.h"
 
 #ifndef M_PI_2
 #define M_PI_2 (3.14159265359f * 0.5f)
@@ -24,16 +34,56 @@
 
 using namespace glm;
 
+namespace {
+
+const int benchmarkWarmup = 30;             /**< frames animated before the benchmark records */
+const float benchmarkStepMs = 1000.f/60.f;  /**< simulation time per benchmark frame */
+const int minRenderScale = 50;              /**< bounds of the render resolution in percent of the window */
+const int maxRenderScale = 100;
+const int renderScaleStep = 5;
+const float maxFrameStepMs = 250.f;         /**< longest time the scene advances in one frame, e.g. after a stall */
+
+/**
+ * @brief printPercentiles prints mean, p50, p95 and p99 of a series of times
+ */
+void printPercentiles(const char* name, std::vector<double> ms)
+{
+    if(ms.empty())
+        return;
+
+    std::sort(ms.begin(), ms.end());
+    auto percentile = [&ms](double p) { return ms[std::min(ms.size() - 1, size_t(p/100.*ms.size()))]; };
+
+    double sum = 0.;
+    for(double t : ms)
+        sum += t;
+
+    std::cout << name << ": mean " << sum/ms.size() << " ms, p50 " << percentile(50.)
+              << " ms, p95 " << percentile(95.) << " ms, p99 " << percentile(99.) << " ms" << std::endl;
+}
+
+}
+
 GLWidget::GLWidget() : QOpenGLWidget(static_cast<QWidget*>(0)),//static_cast<QWidget*>(0)),
-    _updateTimer(this), _stopWatch()
+    _updateTimer(this), _stopWatch(), _pacing(ePacingVsync), _targetFrameMs(1000.f/60.f), _accumulatorMs(0.f),
+    _dirty(true), _sheetDirty(false), _idle(false),
+    _scaleGovernor(1000.f/60.f, minRenderScale, maxRenderScale, renderScaleStep), _screenshotPending(false),
+    _spacetimeCpuMs(0.), _spacetimeGpuMs(0.), _spacetimeLastGpuMs(0.), _spacetimeEvaluations(0), _spacetimeFarEvaluations(0), _spacetimeMaxSteps(0), _spacetimeCapped(0), _spacetimeFrames(0), _spacetimeDraws(0), _frameGpuMs(0.),
+    _benchmarkFrames(0), _benchmarkFrame(0)
 {
-    // update the scene periodically
+    // the next frame is started when the last one was swapped, the timer only delays it in the capped pacing
+    _updateTimer.setSingleShot(true);
+    _updateTimer.setTimerType(Qt::PreciseTimer);
     QObject::connect(&_updateTimer, SIGNAL(timeout()), this, SLOT(animateGL()));
-    _updateTimer.start(18);
+    QObject::connect(this, SIGNAL(frameSwapped()), this, SLOT(scheduleFrame()));
     _stopWatch.start();
+    _pacingWatch.start();
 
     cameraBelow=false;
 
+    // receive key events
+    setFocusPolicy(Qt::StrongFocus);
+
     float omega = 4*M_PI_2/15.;
 
     _skybox    = std::make_shared<Skybox>("Skybox", ":/res/images/stars.bmp");
@@ -41,6 +91,8 @@ GLWidget::GLWidget() : QOpenGLWidget(static_cast<QWidget*>(0)),//static_cast<QWi
                                                   //radius //orbital radius //spin //orbital frequency
     _planet1   = std::make_shared<Planet>("planet1", 0.02, 0.05, 4., omega, 0.,      ":/res/images/neutronstar.bmp");
     _planet2   = std::make_shared<Planet>("planet2", 0.02, 0.05, 4., omega, 2*M_PI_2,":/res/images/neutronstar.bmp");
+    _hud       = std::make_shared<Hud>("HUD");
+    _upscaler  = std::make_shared<Upscaler>("Upscaler");
 }
 
 void GLWidget::show()
@@ -54,6 +106,36 @@ void GLWidget::show()
     }
 }
 
+void GLWidget::setPacing(eFramePacing pacing, float rateHz)
+{
+    _pacing = pacing;
+    _targetFrameMs = 1000.f/rateHz;
+}
+
+void GLWidget::startBenchmark(int frames)
+{
+    _benchmarkFrames = frames;
+
+    // the next frame starts as soon as the last one is on screen
+    setPacing(ePacingUnlimited);
+}
+
+void GLWidget::scheduleFrame()
+{
+    if(_pacing == ePacingCapped)
+    {
+        // rounded up, a frame started early would exceed the target rate
+        int remainingMs = int(std::ceil(_targetFrameMs - _pacingWatch.nsecsElapsed()/1e6));
+        if(remainingMs > 0)
+        {
+            _updateTimer.start(remainingMs);
+            return;
+        }
+    }
+
+    animateGL();
+}
+
 void GLWidget::initializeGL()
 {
     /* Initialize OpenGL extensions */
@@ -69,21 +151,73 @@ void GLWidget::initializeGL()
     // make sure the context is current
     makeCurrent();
 
+    Trace::setThreadName("gui");
+    _gpuTrace.reset(new GpuTrace());
+
     /// Init all drawables here
     _skybox->init();
     _spacetime->init();
     _planet1->init();
     _planet2->init();
+    _hud->init();
+    _upscaler->init();
+
+    _spacetimeTimer.reset(new GpuTimer());
+    _frameTimer.reset(new GpuTimer());
+
+    // hold the target rate, or the refresh rate of the display
+    float frameMs = _targetFrameMs;
+    if(_pacing != ePacingCapped)
+        if(QScreen* screen = QGuiApplication::primaryScreen())
+            if(screen->refreshRate() > 0.)
+                frameMs = 1000./screen->refreshRate();
+    _governor.setBudget(frameMs);
+    _scaleGovernor.setBudget(frameMs);
+
+    // the benchmark produces the sheet synchronously at fixed time steps, with a fixed workload
+    if(_benchmarkFrames > 0)
+    {
+        _governor.setEnabled(false);
+        _scaleGovernor.setEnabled(false);
+        return;
+    }
+
+    // the sheet is computed on its own thread from now on
+    _simulation = std::make_shared<Simulation>(_spacetime, frameMs);
+    _simulation->start();
 }
 
 void GLWidget::resizeGL(int width, int height)
 {
     // update the viewport
     glViewport(0, 0, width, height);
+
+    // the scene is scaled to the window in device pixels
+    _upscaler->resize(width*devicePixelRatioF(), height*devicePixelRatioF());
+
+    invalidate();
 }
 
 void GLWidget::paintGL()
 {
+    TRACE_SCOPE("GLWidget::paintGL");
+    _gpuTrace->collect();
+
+    // GPU time of the whole frame, earlier frames are read back once their results are available
+    double gpuMs;
+    while(_frameTimer->poll(gpuMs))
+    {
+        _frameGpuMs = gpuMs;
+        if(_benchmarkFrames > 0 && _benchmarkFrame > benchmarkWarmup)
+            _benchmarkGpuMs.push_back(_frameGpuMs);
+    }
+    _frameTimer->begin();
+
+    // the scene goes into the offscreen framebuffer of the render scale, screenshots into one of the window size
+    bool screenshot = _screenshotPending;
+    _screenshotPending = false;
+    _upscaler->begin(screenshot);
+
     //change to black background
     glClearColor(0.0f,0.0f,0.0f,0.0f);
 	
@@ -103,15 +237,56 @@ void GLWidget::paintGL()
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    _skybox->draw(projection_matrix);
-    _spacetime->draw(projection_matrix);
-    _planet1->draw(projection_matrix);
-    _planet2->draw(projection_matrix);
+    {
+        TRACE_GPU_SCOPE(*_gpuTrace, "Skybox::draw");
+        _skybox->draw(projection_matrix);
+    }
+
+    // the same for the sheet alone, the last value is kept until a newer one is available
+    while(_spacetimeTimer->poll(gpuMs))
+    {
+        _spacetimeLastGpuMs = gpuMs;
+        _spacetimeGpuMs += gpuMs;
+        ++_spacetimeDraws;
+    }
+    _spacetimeTimer->begin();
+    {
+        TRACE_GPU_SCOPE(*_gpuTrace, "Spacetime::draw");
+        _spacetime->draw(projection_matrix);
+    }
+    _spacetimeTimer->end();
+
+    {
+        TRACE_GPU_SCOPE(*_gpuTrace, "Planet::draw");
+        _planet1->draw(projection_matrix);
+        _planet2->draw(projection_matrix);
+    }
     
     glEnable(GL_BLEND);
     glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
     glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_DEPTH_TEST);
+
+    if(screenshot)
+    {
+        if(_upscaler->save("cbmrnp-screenshot.png"))
+            std::cout << "screenshot written to cbmrnp-screenshot.png" << std::endl;
+        else
+            std::cerr << "could not write cbmrnp-screenshot.png" << std::endl;
+    }
+
+    {
+        TRACE_GPU_SCOPE(*_gpuTrace, "Upscaler::draw");
+        _upscaler->end(defaultFramebufferObject());
+    }
+
+    // the HUD is drawn at the window resolution, so the text stays sharp
+    {
+        TRACE_GPU_SCOPE(*_gpuTrace, "Hud::draw");
+        _hud->draw(projection_matrix);
+    }
+
+    _frameTimer->end();
 }
 
 //default values for camera position
@@ -140,6 +315,7 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
     {
         theta += radians(2.0*float(diff.y)/(-radius));
         phi += radians(2.0*float(diff.x)/(-radius));
+        invalidate();
     }
     //update mouse position
     mouse_pos = ivec2(event->pos().x(), event->pos().y());
@@ -151,35 +327,284 @@ void GLWidget::wheelEvent(QWheelEvent *event)
     if((radius + radians((float)event->angleDelta().ry())/8.0f)<0) //won't zoom past origin/lookat point
     {
         radius += radians((float)event->angleDelta().ry())/8.0f;
+        invalidate();
+    }
+}
+
+void GLWidget::keyPressEvent(QKeyEvent *event)
+{
+    switch(event->key())
+    {
+    case Qt::Key_P:
+        printSpacetimeTiming();
+        _spacetime->setRenderPath(eRenderPath((_spacetime->getRenderPath() + 1) % eRenderPathCount));
+        _governor.reset();
+        invalidate(true);
+        std::cout << "spacetime render path: " << renderPathName(_spacetime->getRenderPath()) << std::endl;
+        break;
+    case Qt::Key_F:
+        printSpacetimeTiming();
+        _spacetime->setFarFieldTolerance(_spacetime->getFarFieldTolerance() > 0.f ? 0.f : 1e-5f);
+        invalidate(true);
+        std::cout << "spacetime far field: " << (_spacetime->getFarFieldTolerance() > 0.f ? "on" : "off") << std::endl;
+        break;
+    case Qt::Key_C:
+        _spacetime->setCurvatureColouring(!_spacetime->getCurvatureColouring());
+        invalidate();
+        std::cout << "curvature colouring: " << (_spacetime->getCurvatureColouring() ? "on" : "off") << std::endl;
+        break;
+    case Qt::Key_M:
+        _spacetime->setPotentialModel(ePotentialModel((_spacetime->getPotentialModel() + 1) % eModelCount));
+        invalidate(true);
+        std::cout << "potential model: " << potentialModelName(_spacetime->getPotentialModel()) << std::endl;
+        break;
+    case Qt::Key_G:
+        _governor.setEnabled(!_governor.isEnabled());
+        _scaleGovernor.setEnabled(_governor.isEnabled());
+        std::cout << "resolution governors: " << (_governor.isEnabled() ? "on" : "off")
+                  << ", nside " << _spacetime->getNside() << ", render scale " << _upscaler->getScale() << "%" << std::endl;
+        break;
+    case Qt::Key_S:
+        _screenshotPending = true;
+        invalidate();
+        break;
+    case Qt::Key_H:
+        _hud->setVisible(!_hud->isVisible());
+        invalidate();
+        break;
+    case Qt::Key_Space:
+        togglePause();
+        break;
+#ifdef HAVE_TRACE
+    case Qt::Key_T:
+        if(Trace::isRecording())
+        {
+            Trace::stop();
+            if(Trace::write("cbmrnp-trace.json"))
+                std::cout << "trace written to cbmrnp-trace.json" << std::endl;
+            else
+                std::cerr << "could not write cbmrnp-trace.json" << std::endl;
+        }
+        else
+        {
+            Trace::start();
+            std::cout << "trace recording, press T again to write it" << std::endl;
+        }
+        break;
+#endif
+    default:
+        QOpenGLWidget::keyPressEvent(event);
     }
 }
 
 void GLWidget::animateGL()
 {
+    TRACE_SCOPE("GLWidget::animateGL");
+
     // make the context current in case there are glFunctions called
     makeCurrent();
 
+    // while paused and nothing changed, the loop stops until invalidate() restarts it
+    bool playing = Config::isPlaying || _benchmarkFrames > 0;
+    if(!playing && !_dirty)
+    {
+        _idle = true;
+        return;
+    }
+    _idle = false;
+    _dirty = false;
+
+    _pacingWatch.restart();
+
     // get the time delta
     float timeElapsedMs = _stopWatch.nsecsElapsed() / 1000000.0f;
     // restart stopwatch for next update
     _stopWatch.restart();
 
+    // the scene advances in whole fixed steps, the rest is carried over to the next frame
+    _accumulatorMs = playing ? std::min(_accumulatorMs + timeElapsedMs, maxFrameStepMs) : 0.f;
+    float stepMs = std::floor(_accumulatorMs/Simulation::stepMs)*Simulation::stepMs;
+    _accumulatorMs -= stepMs;
+
+    // the stopped simulation produces the sheet once after a setting changed
+    if(_sheetDirty && _simulation && !_simulation->isRunning())
+        _simulation->refresh();
+    _sheetDirty = false;
+
+    // the benchmark runs at a fixed time step along the scripted camera path
+    if(_benchmarkFrames > 0)
+    {
+        if(_benchmarkFrame > benchmarkWarmup)
+            _benchmarkFrameMs.push_back(_frameWatch.nsecsElapsed()/1e6);
+        _frameWatch.start();
+
+        if(_benchmarkFrame == benchmarkWarmup + _benchmarkFrames)
+        {
+            finishBenchmark();
+            return;
+        }
+
+        stepMs = benchmarkStepMs;
+        benchmarkCamera(_benchmarkFrame);
+    }
+
     // calculate current modelViewMatrix for the default camera
     glm::vec3 camera = glm::vec3( -radius * sin(theta) * sin(phi), radius * cos(theta), radius * sin(theta)* cos(phi));
     glm::vec3 focus = glm::vec3(0.0f, -0.2f, 0.0f);
 
     glm::mat4 modelViewMatrix = glm::lookAt(camera, focus, glm::vec3(0.0, 1.0, 0.0));
 
+    // pick up the latest frame of the simulation thread, the planets follow its body positions
+    if(_simulation && _simulation->acquire())
+    {
+        const SpacetimeFrame& frame = _simulation->frame();
+        _spacetime->uploadFrame(frame);
+        _planet1->setOrbitPosition(frame.bodies[0]);
+        _planet2->setOrbitPosition(frame.bodies[1]);
+
+        _spacetimeCpuMs += frame.cpuMs;
+        _spacetimeEvaluations += (frame.stats.points + frame.stats.farPoints)/2; // two bodies per evaluation
+        _spacetimeFarEvaluations += frame.stats.farPoints/2;
+        _spacetimeMaxSteps = std::max(_spacetimeMaxSteps, frame.stats.maxIterations());
+        _spacetimeCapped += frame.stats.capped;
+        ++_spacetimeFrames;
+    }
+
     // update drawables
-    _skybox->update(timeElapsedMs, modelViewMatrix);
-    _planet1->update(timeElapsedMs, modelViewMatrix);
-    _planet2->update(timeElapsedMs, modelViewMatrix);
-    _spacetime->update(timeElapsedMs, modelViewMatrix);
-    _spacetime->recreate();
+    _skybox->update(stepMs, modelViewMatrix);
+    _planet1->update(stepMs, modelViewMatrix);
+    _planet2->update(stepMs, modelViewMatrix);
+    _spacetime->update(stepMs, modelViewMatrix);
+
+    if(_hud->isVisible())
+    {
+        HudStats stats;
+        stats.renderPath = renderPathName(_spacetime->getActivePath());
+        stats.model = potentialModelName(_spacetime->getPotentialModel());
+        stats.nside = _spacetime->getNside();
+        stats.renderScale = _upscaler->getScale();
+        stats.cpuMs = _spacetime->getFrameCpuMs();
+        stats.gpuMs = _spacetimeLastGpuMs;
+        stats.newton = _spacetime->getNewtonStats();
+        stats.uploadedBytes = _spacetime->getUploadedBytes();
+        _hud->setStats(stats);
+    }
+    _hud->update(timeElapsedMs, modelViewMatrix);
+
+    // the render scale follows the GPU time of the whole frame, which is dominated by the fill rate in large windows
+    if(_scaleGovernor.isEnabled())
+    {
+        int scale = _upscaler->getScale();
+        int next = _scaleGovernor.update(0., _frameGpuMs, scale);
+        if(next != scale)
+            _upscaler->setScale(next);
+    }
+
+    // only the grid of these paths follows nside, it is held to the physics and the sheet itself
+    eRenderPath path = _spacetime->getActivePath();
+    if(_simulation && (path == ePathStreamed || path == ePathCorotating || path == ePathHeightTexture || path == ePathKeyframed))
+    {
+        double renderMs = std::max(_stopWatch.nsecsElapsed()/1e6, _spacetimeLastGpuMs);
+        int side = _spacetime->getNside();
+        int next = _governor.update(_spacetime->getFrameCpuMs(), renderMs, side);
+        if(next != side)
+        {
+            _spacetime->setNside(next);
+            invalidate(true);
+        }
+    }
+
+    if(_benchmarkFrames > 0)
+    {
+        _spacetime->recreate();
+        if(_benchmarkFrame >= benchmarkWarmup)
+            _benchmarkCpuMs.push_back(_stopWatch.nsecsElapsed()/1e6);
+        ++_benchmarkFrame;
+    }
 
     // update the widget (do not remove this!)
     update();
 }
 
+void GLWidget::invalidate(bool sheet)
+{
+    _dirty = true;
+    _sheetDirty = _sheetDirty || sheet;
+
+    if(_idle)
+    {
+        _idle = false;
+        animateGL();
+    }
+}
+
+void GLWidget::togglePause()
+{
+    if(!_simulation)
+        return;
+
+    if(Config::isPlaying)
+    {
+        Config::pauseTime = _simulation->stop();
+        Config::isPlaying = false;
+        std::cout << "paused at t = " << Config::pauseTime << " s" << std::endl;
+    }
+    else
+    {
+        _simulation->start(Config::pauseTime);
+        Config::isPlaying = true;
+        _stopWatch.restart();
+        std::cout << "resumed" << std::endl;
+    }
+
+    invalidate();
+}
+
+void GLWidget::benchmarkCamera(int frame)
+{
+    // one turn around the binary while dipping towards the sheet and zooming in and out twice
+    double s = double(frame)/double(benchmarkWarmup + _benchmarkFrames);
+    phi = 8*M_PI_2*s;
+    theta = (1.2 - 0.3*std::sin(8*M_PI_2*s))*M_PI_2;
+    radius = -1.0 - 0.6*std::sin(4*M_PI_2*s)*std::sin(4*M_PI_2*s);
+}
+
+void GLWidget::finishBenchmark()
+{
+    QObject::disconnect(this, SIGNAL(frameSwapped()), this, SLOT(scheduleFrame()));
+
+    std::cout << "benchmark: " << _benchmarkFrames << " frames after " << benchmarkWarmup
+              << " warm-up frames, " << benchmarkStepMs << " ms per step, render path "
+              << renderPathName(_spacetime->getActivePath()) << std::endl;
+    printPercentiles("cpu update", _benchmarkCpuMs);
+    printPercentiles("gpu draw  ", _benchmarkGpuMs);
+    printPercentiles("frame time", _benchmarkFrameMs);
+
+    QCoreApplication::quit();
+}
+
 
 
+
+void GLWidget::printSpacetimeTiming()
+{
+    if(_spacetimeFrames == 0 || _spacetimeDraws == 0)
+        return;
+
+    std::cout << "spacetime (" << renderPathName(_spacetime->getActivePath()) << "): "
+              << _spacetimeCpuMs/_spacetimeFrames << " ms CPU and "
+              << _spacetimeEvaluations/_spacetimeFrames << " potential evaluations per simulated frame ("
+              << (_spacetimeEvaluations ? 100*_spacetimeFarEvaluations/_spacetimeEvaluations : 0) << "% far field, at most "
+              << _spacetimeMaxSteps << " solver steps per point, " << _spacetimeCapped << " capped), "
+              << _spacetimeGpuMs/_spacetimeDraws << " ms GPU per drawn frame over "
+              << _spacetimeFrames << " simulated and " << _spacetimeDraws << " drawn frames" << std::endl;
+
+    _spacetimeCpuMs = 0.;
+    _spacetimeGpuMs = 0.;
+    _spacetimeEvaluations = 0;
+    _spacetimeFarEvaluations = 0;
+    _spacetimeMaxSteps = 0;
+    _spacetimeCapped = 0;
+    _spacetimeFrames = 0;
+    _spacetimeDraws = 0;
+}
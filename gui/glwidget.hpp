@@ -2,6 +2,7 @@
 #define GLWIDGET_H
 
 #include <memory>
+#include <vector>
 
 #include <QElapsedTimer>
 #include <QMessageBox>
@@ -9,12 +10,29 @@
 #include <QOpenGLContext>
 #include <QTimer>
 
+#include "gui/governor.h"
+
+/**
+ * @brief The eFramePacing enum lists how the widget schedules its frames
+ */
+enum eFramePacing
+{
+    ePacingVsync,       /**< one frame per vertical retrace of the display */
+    ePacingCapped,      /**< no vsync, at most the target rate */
+    ePacingUnlimited    /**< no vsync, the next frame starts as soon as the last one was swapped */
+};
+
 /*
  * Forward decleration
  */
 class Spacetime;
 class Skybox;
 class Planet;
+class Simulation;
+class GpuTrace;
+class GpuTimer;
+class Hud;
+class Upscaler;
 
 /**
  * @brief The GLWidget class handling the opengl widget
@@ -28,13 +46,65 @@ class GLWidget : public QOpenGLWidget
 
 private:
 
-    QTimer _updateTimer;        /**< Used for regular frame updates */
+    QTimer _updateTimer;        /**< Delays the next frame in the capped pacing */
     QElapsedTimer _stopWatch;   /**< Measures time between updates */
+    QElapsedTimer _pacingWatch; /**< Measures the time since the current frame started */
+    eFramePacing _pacing;
+    float _targetFrameMs;       /**< frame period of the capped pacing */
+    float _accumulatorMs;       /**< wall clock time not yet advanced in whole simulation steps */
+    bool _dirty;                /**< the camera, the window or a setting changed since the last frame */
+    bool _sheetDirty;           /**< a setting of the sheet changed while paused, it has to be produced again */
+    bool _idle;                 /**< no frame is scheduled, see invalidate() */
 
     std::shared_ptr<Spacetime> _spacetime;
     std::shared_ptr<Skybox> _skybox;
     std::shared_ptr<Planet> _planet1;
     std::shared_ptr<Planet> _planet2;
+    std::shared_ptr<Simulation> _simulation;   /**< produces the frames of _spacetime */
+    std::shared_ptr<Hud> _hud;                  /**< performance overlay, toggled with H */
+    std::shared_ptr<Upscaler> _upscaler;        /**< renders the scene at a reduced resolution */
+
+    std::unique_ptr<GpuTrace> _gpuTrace;        /**< GPU zones of the trace recording */
+    Governor _governor;                         /**< adapts the resolution of the sheet, toggled with G */
+    Governor _scaleGovernor;                    /**< adapts the render scale to the GPU time, toggled with G */
+    bool _screenshotPending;                    /**< the next frame is saved at the window resolution */
+
+    // timing of the spacetime sheet, to compare its render paths
+    std::unique_ptr<GpuTimer> _spacetimeTimer;  /**< GPU time of Spacetime::draw() */
+    double _spacetimeCpuMs;         /**< accumulated CPU time of Spacetime::produceFrame() */
+    double _spacetimeGpuMs;         /**< accumulated GPU time of Spacetime::draw() */
+    double _spacetimeLastGpuMs;     /**< GPU time of the last Spacetime::draw() that was read back */
+    long long _spacetimeEvaluations;/**< accumulated potential evaluations */
+    long long _spacetimeFarEvaluations; /**< accumulated evaluations by the far-field expansion */
+    int _spacetimeMaxSteps;         /**< most retarded time solver steps any point took */
+    long long _spacetimeCapped;     /**< accumulated points that hit the solver iteration cap */
+    int _spacetimeFrames;           /**< simulated frames that were picked up */
+    int _spacetimeDraws;            /**< drawn frames with a GPU time */
+    std::unique_ptr<GpuTimer> _frameTimer;  /**< GPU time of paintGL() */
+    double _frameGpuMs;             /**< GPU time of the last frame that was read back */
+
+    /**
+     * @brief printSpacetimeTiming prints and resets the accumulated timing of the current render path
+     */
+    void printSpacetimeTiming();
+
+    // benchmark mode: scripted camera, fixed timestep, no simulation thread
+    int _benchmarkFrames;           /**< frames to record, 0 in interactive use */
+    int _benchmarkFrame;            /**< frames animated so far, including the warm-up */
+    QElapsedTimer _frameWatch;      /**< measures the time between two frames */
+    std::vector<double> _benchmarkCpuMs;    /**< per frame: animateGL() including the sheet */
+    std::vector<double> _benchmarkGpuMs;    /**< per frame: GPU time of paintGL() */
+    std::vector<double> _benchmarkFrameMs;  /**< per frame: time since the previous frame */
+
+    /**
+     * @brief benchmarkCamera sets the camera of a frame on the scripted path
+     */
+    void benchmarkCamera(int frame);
+
+    /**
+     * @brief finishBenchmark prints the benchmark results and quits the application
+     */
+    void finishBenchmark();
 protected:
 
     bool cameraBelow;
@@ -48,15 +118,42 @@ private slots:
      */
     void animateGL();
 
+    /**
+     * @brief scheduleFrame starts the next frame once the last one was swapped
+     *
+     * With vsync the swap already waited for the retrace and the next
+     * frame starts at once, as it does in the unlimited pacing. The
+     * capped pacing waits for the rest of the target period first.
+     */
+    void scheduleFrame();
+
+    /**
+     * @brief invalidate marks the scene as changed and restarts the frame loop if it is idle
+     * @param sheet the sheet has to be produced again, e.g. after its render path changed
+     *
+     * While the animation is paused animateGL() only updates and redraws
+     * the scene after a change, otherwise it lets the loop stop.
+     */
+    void invalidate(bool sheet = false);
+
+    /**
+     * @brief togglePause pauses or resumes the animation
+     *
+     * While paused the simulation thread is stopped and Config::pauseTime
+     * holds the simulation time it resumes from.
+     */
+    void togglePause();
+
 public:
     /**
      * @brief setGLFormat sets the GL format to 4.0 core
+     * @param pacing only ePacingVsync waits for the vertical retrace when swapping
      */
-    static void setGLFormat ()
+    static void setGLFormat (eFramePacing pacing = ePacingVsync)
     {
         QSurfaceFormat format;
         format.setSwapBehavior(QSurfaceFormat::DoubleBuffer);
-        format.setSwapInterval(::getenv("COREGL_FPS") ? 0 : 1);
+        format.setSwapInterval(pacing == ePacingVsync ? 1 : 0);
         format.setVersion(4, 0);
         format.setProfile(QSurfaceFormat::CoreProfile);
         QSurfaceFormat::setDefaultFormat(format);
@@ -75,6 +172,29 @@ public:
      */
     virtual void show();
 
+    /**
+     * @brief setPacing sets how frames are scheduled, call before show()
+     * @param pacing the pacing, it has to match the one of setGLFormat()
+     * @param rateHz the target frame rate of ePacingCapped
+     *
+     * A frame is started when the last one was swapped, so frames follow
+     * the display instead of beating against it. The scene advances in
+     * fixed simulation steps of the wall clock, independent of the rate.
+     */
+    void setPacing(eFramePacing pacing, float rateHz = 60.f);
+
+    /**
+     * @brief startBenchmark switches to the benchmark mode, call before show()
+     * @param frames number of frames to time
+     *
+     * A new frame is started as soon as the last one was swapped. The
+     * camera follows a scripted path and the simulation advances by a
+     * fixed 1/60 s per frame, with the sheet produced synchronously, so
+     * runs are comparable between builds and machines. After the frames
+     * the CPU, GPU and frame times are printed and the application quits.
+     */
+    void startBenchmark(int frames);
+
     /**
      * @brief initializeGL initializes the context
      *
@@ -118,6 +238,18 @@ public:
      */
     virtual void wheelEvent(QWheelEvent *event) override;
 
+    /**
+     * @brief keyPressEvent automatically called whenever a key is pressed
+     * @param event the QKeyEvent containing all relevant data
+     *
+     * P cycles through the render paths of the spacetime sheet, T starts
+     * a trace recording and writes it on the next press, H shows or hides
+     * the performance HUD, G switches the resolution governors on or off,
+     * S saves a screenshot at the window resolution, Space pauses and
+     * resumes the animation
+     */
+    virtual void keyPressEvent(QKeyEvent *event) override;
+
 public slots:
 
 
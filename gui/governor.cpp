@@ -0,0 +1,127 @@
+#include "gui/governor.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+const double targetLoad = 0.75;     /**< load aimed for after a change, as fraction of the budget */
+const double upperLoad = 0.9;       /**< dead band around the target */
+const double lowerLoad = 0.5;
+const double smoothing = 0.1;       /**< weight of a new measurement in the smoothed load */
+const double maxGrowth = 1.25;      /**< largest factor of a single step up */
+const int shrinkFrames = 10;        /**< frames over the band before shrinking */
+const int growFrames = 90;          /**< frames under the band before growing */
+const int settleFrames = 30;        /**< frames ignored after a change, until it shows in the timing */
+const int cooldownFrames = 600;     /**< frames before a too slow resolution is tried again */
+
+}
+
+Governor::Governor(float budgetMs, int minSide, int maxSide, int step) :
+    _budgetMs(budgetMs), _minSide(minSide), _maxSide(maxSide), _step(step), _enabled(true)
+{
+    reset();
+}
+
+int
+Governor::update(double physicsMs, double renderMs, int side)
+{
+    if(!_enabled)
+        return side;
+
+    if(_settleFrames > 0)
+    {
+        --_settleFrames;
+        return side;
+    }
+
+    double load = std::max(physicsMs, renderMs);
+    _load = (_load < 0.) ? load : _load + smoothing*(load - _load);
+
+    if(_cooldownFrames > 0 && --_cooldownFrames == 0)
+        _ceilingSide = INT_MAX;
+
+    _overFrames = (_load > upperLoad*_budgetMs) ? _overFrames + 1 : 0;
+    _underFrames = (_load < lowerLoad*_budgetMs) ? _underFrames + 1 : 0;
+
+    // the cost grows with side^2
+    double fit = side*std::sqrt(targetLoad*_budgetMs/std::max(_load, 1e-3));
+
+    int next = side;
+    if(_overFrames >= shrinkFrames)
+    {
+        next = std::min(clampSide(fit), std::max(_minSide, side - _step));
+
+        // remember what was too slow, so the governor does not grow straight back
+        if(next < side)
+        {
+            _ceilingSide = side;
+            _cooldownFrames = cooldownFrames;
+        }
+    }
+    else if(_underFrames >= growFrames)
+    {
+        next = clampSide(std::min(fit, maxGrowth*side));
+        if(_ceilingSide != INT_MAX)
+            next = std::min(next, _ceilingSide - _step);
+        next = std::max(next, side);
+    }
+
+    if(next != side)
+    {
+        _load = -1.;
+        _settleFrames = settleFrames;
+    }
+    if(_overFrames >= shrinkFrames || _underFrames >= growFrames)
+    {
+        _overFrames = 0;
+        _underFrames = 0;
+    }
+
+    return next;
+}
+
+void
+Governor::reset()
+{
+    _load = -1.;
+    _overFrames = 0;
+    _underFrames = 0;
+    _settleFrames = settleFrames;
+    _ceilingSide = INT_MAX;
+    _cooldownFrames = 0;
+}
+
+void
+Governor::setBudget(float budgetMs)
+{
+    _budgetMs = budgetMs;
+    reset();
+}
+
+float
+Governor::getBudget() const
+{
+    return _budgetMs;
+}
+
+void
+Governor::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+    reset();
+}
+
+bool
+Governor::isEnabled() const
+{
+    return _enabled;
+}
+
+int
+Governor::clampSide(double side) const
+{
+    int rounded = int(std::round(side/_step))*_step;
+    return std::max(_minSide, std::min(_maxSide, rounded));
+}
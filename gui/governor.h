@@ -0,0 +1,84 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+/**
+ * @brief The Governor class adapts a resolution to a frame budget
+ *
+ * It is used for the grid resolution of the sheet and for the render
+ * scale of the scene in percent. Every frame it is given two times, e.g.
+ * the time the physics took for the sheet and the time the frame took to
+ * render. Their smoothed maximum is the load. The cost grows with the
+ * square of the resolution (vertices of the grid, pixels of the scene),
+ * so the resolution that fits the budget is estimated from the load as
+ * side*sqrt(target/load), rounded to a multiple of the step.
+ *
+ * To keep the mesh from flickering between resolutions, the governor only
+ * acts when the load leaves a dead band around the target for a number
+ * of consecutive frames (longer to grow than to shrink), lets the
+ * measurements settle after every change, and does not grow back to a
+ * resolution that was too slow until a cooldown has passed.
+ */
+class Governor
+{
+public:
+    /**
+     * @brief Governor constructor
+     * @param budgetMs the frame time to hold
+     * @param minSide the coarsest resolution
+     * @param maxSide the finest resolution
+     * @param step the resolution changes by multiples of this
+     */
+    Governor(float budgetMs = 1000.f/60.f, int minSide = 50, int maxSide = 400, int step = 10);
+
+    /**
+     * @brief update passes the measurements of a frame
+     * @param physicsMs time it took to produce the sheet that is drawn
+     * @param renderMs time the last frame took to render
+     * @param side resolution the measurements belong to
+     * @return the resolution to use from now on
+     */
+    int update(double physicsMs, double renderMs, int side);
+
+    /**
+     * @brief reset forgets all measurements, e.g. after the render path changed
+     */
+    void reset();
+
+    /**
+     * @brief setBudget sets the frame time to hold
+     */
+    void setBudget(float budgetMs);
+
+    /**
+     * @brief getBudget Getter for the frame time to hold
+     */
+    float getBudget() const;
+
+    /**
+     * @brief setEnabled switches the governor on or off, a disabled one keeps the resolution
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief isEnabled Getter for whether the governor adapts the resolution
+     */
+    bool isEnabled() const;
+
+private:
+    int clampSide(double side) const;
+
+    float _budgetMs;
+    int _minSide;
+    int _maxSide;
+    int _step;
+    bool _enabled;
+
+    double _load;           /**< smoothed load in ms, negative until the first measurement */
+    int _overFrames;        /**< consecutive frames above the dead band */
+    int _underFrames;       /**< consecutive frames below the dead band */
+    int _settleFrames;      /**< frames to ignore after a change */
+    int _ceilingSide;       /**< resolution that was too slow, not reached again during the cooldown */
+    int _cooldownFrames;    /**< frames until _ceilingSide is lifted */
+};
+
+#endif // GOVERNOR_H
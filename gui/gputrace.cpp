@@ -0,0 +1,130 @@
+#include "gui/gputrace.h"
+
+GpuTrace::GpuTrace() :
+    _open(false)
+{
+}
+
+GLuint
+GpuTrace::query()
+{
+    if(_queries.empty())
+    {
+        GLuint queries[16];
+        glGenQueries(16, queries);
+        _queries.assign(queries, queries + 16);
+    }
+
+    GLuint query = _queries.back();
+    _queries.pop_back();
+    return query;
+}
+
+void
+GpuTrace::begin(const char* name)
+{
+    if(_open || !Trace::isRecording())
+        return;
+
+    Pending zone;
+    zone.name = name;
+    zone.timestamp = query();
+    zone.elapsed = query();
+
+    glQueryCounter(zone.timestamp, GL_TIMESTAMP);
+    glBeginQuery(GL_TIME_ELAPSED, zone.elapsed);
+
+    _pending.push_back(zone);
+    _open = true;
+}
+
+void
+GpuTrace::end()
+{
+    if(!_open)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    _open = false;
+}
+
+void
+GpuTrace::collect()
+{
+    if(_pending.empty())
+        return;
+
+    // the offset between the GPU clock and the trace clock, the drift over a frame is negligible
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    int64_t offset = Trace::now() - gpuNow;
+
+    // zones complete in order, the open one is never available
+    while(_pending.size() > (_open ? 1u : 0u))
+    {
+        const Pending& zone = _pending.front();
+
+        GLint available = 0;
+        glGetQueryObjectiv(zone.elapsed, GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            break;
+
+        GLuint64 begin = 0, elapsed = 0;
+        glGetQueryObjectui64v(zone.timestamp, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.elapsed, GL_QUERY_RESULT, &elapsed);
+        Trace::addGpuEvent(zone.name, int64_t(begin) + offset, int64_t(begin + elapsed) + offset);
+
+        _queries.push_back(zone.timestamp);
+        _queries.push_back(zone.elapsed);
+        _pending.pop_front();
+    }
+}
+
+GpuTimer::GpuTimer() :
+    _issued(0), _read(0), _open(false)
+{
+    glGenQueries(2*ringSize, _queries);
+}
+
+void
+GpuTimer::begin()
+{
+    // every slot still waits for the GPU, this frame is skipped
+    if(_issued - _read == ringSize)
+        return;
+
+    glQueryCounter(_queries[2*(_issued % ringSize)], GL_TIMESTAMP);
+    _open = true;
+}
+
+void
+GpuTimer::end()
+{
+    if(!_open)
+        return;
+
+    glQueryCounter(_queries[2*(_issued % ringSize) + 1], GL_TIMESTAMP);
+    ++_issued;
+    _open = false;
+}
+
+bool
+GpuTimer::poll(double& ms)
+{
+    if(_read == _issued)
+        return false;
+
+    // the timestamps complete in order, the second one of a pair is the last
+    const GLuint* pair = &_queries[2*(_read % ringSize)];
+    GLint available = 0;
+    glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return false;
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+    ms = (end - begin)/1e6;
+    ++_read;
+    return true;
+}
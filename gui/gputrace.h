@@ -0,0 +1,123 @@
+#ifndef GPUTRACE_H
+#define GPUTRACE_H
+
+#include <GL/glew.h>
+
+#include <deque>
+#include <vector>
+
+#include "util/trace.h"
+
+/**
+ * @brief The GpuTrace class adds the GPU time of draw calls to the Trace recording
+ *
+ * A zone is bracketed by a GL_TIME_ELAPSED query, a GL_TIMESTAMP query
+ * at its begin places it on the timeline. The results are read back by
+ * collect() once they are available, usually a frame or two later, so
+ * the pipeline never stalls. Zones are only issued while Trace is
+ * recording and may not be nested, since GL_TIME_ELAPSED queries can
+ * not be.
+ */
+class GpuTrace
+{
+public:
+    GpuTrace();
+
+    /**
+     * @brief begin opens a zone, ignored if no recording runs or a zone is open
+     * @param name the name, has to stay valid until the recording is written
+     */
+    void begin(const char* name);
+
+    /**
+     * @brief end closes the open zone
+     */
+    void end();
+
+    /**
+     * @brief collect passes the zones whose results are available to Trace
+     *
+     * Call once per frame on the thread of the context.
+     */
+    void collect();
+
+    /**
+     * @brief The Zone class is a GPU zone for the duration of a scope
+     */
+    class Zone
+    {
+    public:
+        Zone(GpuTrace& trace, const char* name) : _trace(trace) { _trace.begin(name); }
+        ~Zone() { _trace.end(); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        GpuTrace& _trace;
+    };
+
+private:
+    struct Pending
+    {
+        const char* name;
+        GLuint timestamp;   /**< GL_TIMESTAMP at the begin */
+        GLuint elapsed;     /**< GL_TIME_ELAPSED of the zone */
+    };
+
+    GLuint query();
+
+    std::vector<GLuint> _queries;   /**< unused query objects */
+    std::deque<Pending> _pending;   /**< issued zones, oldest first */
+    bool _open;
+};
+
+/**
+ * @brief The GpuTimer class measures the GPU time between two points of every frame
+ *
+ * begin() and end() write a pair of GL_TIMESTAMP queries into the next
+ * slot of a small ring. poll() reads back the pairs that are complete,
+ * oldest first, and never waits for the GPU. A frame is not measured if
+ * all slots are still in flight.
+ */
+class GpuTimer
+{
+public:
+    GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /**
+     * @brief begin writes the first timestamp of a measurement
+     */
+    void begin();
+
+    /**
+     * @brief end writes the second timestamp of the measurement begin() started
+     */
+    void end();
+
+    /**
+     * @brief poll reads back the oldest complete measurement
+     * @param ms receives its GPU time
+     * @return false if no measurement is available yet
+     */
+    bool poll(double& ms);
+
+private:
+    static const unsigned int ringSize = 4;   /**< measurements that may be in flight */
+
+    GLuint _queries[2*ringSize];
+    unsigned int _issued;   /**< measurements begun */
+    unsigned int _read;     /**< measurements read back */
+    bool _open;             /**< begin() wrote its timestamp, end() did not yet */
+};
+
+#ifdef HAVE_TRACE
+#define TRACE_GPU_SCOPE(trace, name) GpuTrace::Zone TRACE_CONCAT(gpuTraceZone, __LINE__)(trace, name)
+#else
+#define TRACE_GPU_SCOPE(trace, name)
+#endif
+
+#endif // GPUTRACE_H
@@ -12,9 +12,24 @@ int main(int argc, char *argv[])
 
     QApplication app(argc, argv);
 
-    GLWidget::setGLFormat();
+    // vsync by default, COREGL_FPS renders as fast as possible like --fps 0, benchmarks always do
+    float rate = theCli.getFrameRate();
+    if(::getenv("COREGL_FPS"))
+        rate = 0.f;
+
+    eFramePacing pacing = (rate < 0.f) ? ePacingVsync : (rate == 0.f ? ePacingUnlimited : ePacingCapped);
+    if(theCli.getBenchmarkFrames() > 0)
+        pacing = ePacingUnlimited;
+
+    GLWidget::setGLFormat(pacing);
 
     GLWidget glwidget;
+    if(pacing == ePacingCapped)
+        glwidget.setPacing(pacing, rate);
+    else
+        glwidget.setPacing(pacing);
+    if(theCli.getBenchmarkFrames() > 0)
+        glwidget.startBenchmark(theCli.getBenchmarkFrames());
     glwidget.resize(1080, 720);
     //glwidget.resize(1800, 624); // resolution for talk
     glwidget.move(0,1080);
@@ -0,0 +1,283 @@
+#include <GL/glew.h>
+
+#include "hud.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QImage>
+#include <QPainter>
+
+#include "glbase/gltool.hpp"
+#include "util/trace.h"
+
+namespace {
+
+const glm::u8vec4 white(255, 255, 255, 255);
+const glm::u8vec4 grey(160, 160, 160, 255);
+const glm::u8vec4 green(80, 220, 80, 255);
+const glm::u8vec4 yellow(240, 200, 60, 255);
+const glm::u8vec4 red(240, 70, 60, 255);
+const glm::u8vec4 background(0, 0, 0, 160);
+
+const float graphHeight = 80.f;     /**< pixels for graphMaxMs */
+const float graphMaxMs = 50.f;
+const float budgetMs = 1000.f/60.f; /**< frame time at 60 Hz */
+const float margin = 8.f;
+
+}
+
+Hud::Hud(std::string name) : Drawable(name),
+    cellWidth(8), cellHeight(16), vertexBuffer(0), vertexCount(0),
+    frameTimes(historySize, 0.f), nextFrame(0), buildMs(0.), visible(false)
+{
+}
+
+void
+Hud::init()
+{
+    Drawable::init();
+
+    loadTexture();
+}
+
+void
+Hud::draw(glm::mat4 projection_matrix) const
+{
+    TRACE_SCOPE("Hud::draw");
+
+    if(!visible || vertexCount == 0)
+        return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glUseProgram(_program);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glBindVertexArray(_vertexArrayObject);
+
+    glUniform2f(glGetUniformLocation(_program, "viewport"), viewport[2], viewport[3]);
+    glUniform1i(glGetUniformLocation(_program, "atlas"), 0);
+
+    // on top of everything, blended with the scene
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+
+    if(depthTest)
+        glEnable(GL_DEPTH_TEST);
+
+    glBindVertexArray(0);
+
+    VERIFY(CG::checkError());
+}
+
+void
+Hud::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
+{
+    TRACE_SCOPE("Hud::update");
+
+    frameTimes[nextFrame] = elapsedTimeMs;
+    nextFrame = (nextFrame + 1) % historySize;
+
+    if(!visible)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<float> sorted(frameTimes);
+    std::sort(sorted.begin(), sorted.end());
+
+    const RetardedStats& newton = stats.newton;
+    double points = std::max(1ll, newton.points);
+    double evaluations = std::max(1ll, newton.points + newton.farPoints);
+
+    char lines[6][96];
+    std::snprintf(lines[0], sizeof(lines[0]), "frame  p50 %5.1f ms  max %5.1f ms",
+                  sorted[historySize/2], sorted.back());
+    std::snprintf(lines[1], sizeof(lines[1]), "sheet  %s, %s, nside %d, scale %d%%",
+                  stats.renderPath, stats.model, stats.nside, stats.renderScale);
+    std::snprintf(lines[2], sizeof(lines[2]), "cpu    %5.2f ms  body 0 %5.2f ms  body 1 %5.2f ms",
+                  stats.cpuMs, newton.bodyMs[0], newton.bodyMs[1]);
+    std::snprintf(lines[3], sizeof(lines[3]), "solver %4.2f steps/pt  max %2d  capped %lld  warm %3.0f%%  far %3.0f%%",
+                  newton.newtonSteps/points, newton.maxIterations(), newton.capped,
+                  100.*newton.warmStarts/points, 100.*newton.farPoints/evaluations);
+    std::snprintf(lines[4], sizeof(lines[4]), "upload %7.1f KiB/frame  gpu %5.2f ms",
+                  stats.uploadedBytes/1024., stats.gpuMs);
+    std::snprintf(lines[5], sizeof(lines[5]), "hud    %5.3f ms", buildMs);
+
+    vertices.clear();
+
+    // panel behind the text and the graph
+    float width = std::max(2*margin + 64*cellWidth, 2*margin + 2*historySize);
+    float textHeight = 6*cellHeight;
+    solid(0.f, 0.f, width, 3*margin + textHeight + graphHeight, background);
+
+    for(int k = 0; k < 6; ++k)
+        text(margin, margin + k*cellHeight, lines[k], k == 0 ? white : grey);
+
+    // frame time graph, oldest frame on the left
+    float bottom = 2*margin + textHeight + graphHeight;
+    for(int k = 0; k < historySize; ++k)
+    {
+        float ms = frameTimes[(nextFrame + k) % historySize];
+        float height = std::min(ms, graphMaxMs)*graphHeight/graphMaxMs;
+        glm::u8vec4 color = ms <= budgetMs ? green : (ms <= 2*budgetMs ? yellow : red);
+        solid(margin + 2*k, bottom - height, margin + 2*k + 2, bottom, color);
+    }
+
+    // budget lines at 60 and 30 Hz
+    for(float ms : {budgetMs, 2*budgetMs})
+    {
+        float y = bottom - ms*graphHeight/graphMaxMs;
+        solid(margin, y, margin + 2*historySize, y + 1, white);
+    }
+
+    // the whole buffer is respecified, the driver renames it if the last draw still reads from it
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(HudVertex), vertices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    vertexCount = vertices.size();
+
+    buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+Hud::setStats(const HudStats& stats)
+{
+    this->stats = stats;
+}
+
+void
+Hud::setVisible(bool visible)
+{
+    this->visible = visible;
+}
+
+bool
+Hud::isVisible() const
+{
+    return visible;
+}
+
+std::string
+Hud::getVertexShader() const
+{
+    return Drawable::loadShaderFile(":/shader/hud.vs.glsl");
+}
+
+std::string
+Hud::getFragmentShader() const
+{
+    return Drawable::loadShaderFile(":/shader/hud.fs.glsl");
+}
+
+void
+Hud::createObject()
+{
+    glGenVertexArrays(1, &_vertexArrayObject);
+    glBindVertexArray(_vertexArrayObject);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, position));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, texCoord));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void*)offsetof(HudVertex, color));
+    for(GLuint attribute = 0; attribute < 3; ++attribute)
+        glEnableVertexAttribArray(attribute);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    VERIFY(CG::checkError());
+}
+
+GLuint
+Hud::loadTexture()
+{
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    font.setPixelSize(13);
+    QFontMetrics metrics(font);
+    cellWidth = metrics.maxWidth();
+    cellHeight = metrics.height();
+
+    QImage atlas(atlasColumns*cellWidth, atlasRows*cellHeight, QImage::Format_Grayscale8);
+    atlas.fill(0);
+
+    QPainter painter(&atlas);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    for(int c = 32; c < 127; ++c)
+    {
+        int cell = c - 32;
+        int x = (cell % atlasColumns)*cellWidth;
+        int y = (cell / atlasColumns)*cellHeight;
+        painter.drawText(x, y + metrics.ascent(), QString(QChar(c)));
+    }
+    int solidCell = 127 - 32;
+    painter.fillRect((solidCell % atlasColumns)*cellWidth, (solidCell / atlasColumns)*cellHeight,
+                     cellWidth, cellHeight, Qt::white);
+    painter.end();
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, atlas.bytesPerLine());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.width(), atlas.height(), 0, GL_RED, GL_UNSIGNED_BYTE, atlas.constBits());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // glyphs are drawn at whole pixels, so they are sampled without filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    VERIFY(CG::checkError());
+
+    return textureID;
+}
+
+void
+Hud::quad(float x0, float y0, float x1, float y1, glm::vec2 st0, glm::vec2 st1, glm::u8vec4 color)
+{
+    HudVertex a = {glm::vec2(x0, y0), glm::vec2(st0.x, st0.y), color};
+    HudVertex b = {glm::vec2(x1, y0), glm::vec2(st1.x, st0.y), color};
+    HudVertex c = {glm::vec2(x0, y1), glm::vec2(st0.x, st1.y), color};
+    HudVertex d = {glm::vec2(x1, y1), glm::vec2(st1.x, st1.y), color};
+
+    vertices.insert(vertices.end(), {a, c, b, b, c, d});
+}
+
+void
+Hud::solid(float x0, float y0, float x1, float y1, glm::u8vec4 color)
+{
+    // the centre of the white cell
+    int solidCell = 127 - 32;
+    glm::vec2 st((solidCell % atlasColumns + 0.5f)/atlasColumns, (solidCell / atlasColumns + 0.5f)/atlasRows);
+    quad(x0, y0, x1, y1, st, st, color);
+}
+
+void
+Hud::text(float x, float y, const char* line, glm::u8vec4 color)
+{
+    for(const char* c = line; *c; ++c, x += cellWidth)
+    {
+        if(*c <= 32 || *c >= 127)
+            continue;
+
+        int cell = *c - 32;
+        glm::vec2 st0(float(cell % atlasColumns)/atlasColumns, float(cell / atlasColumns)/atlasRows);
+        glm::vec2 st1 = st0 + glm::vec2(1.f/atlasColumns, 1.f/atlasRows);
+        quad(x, y, x + cellWidth, y + cellHeight, st0, st1, color);
+    }
+}
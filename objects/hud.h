@@ -0,0 +1,131 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "objects/drawable.h"
+#include "physics/retardedbatch.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+/**
+ * @brief The HudStats struct is what the HUD shows besides the frame times
+ */
+struct HudStats
+{
+    const char* renderPath = "";    /**< render path of the sheet that is drawn */
+    const char* model = "";         /**< potential profile of the bodies */
+    int nside = 0;                  /**< requested grid resolution */
+    int renderScale = 100;          /**< render resolution in percent of the window */
+    double cpuMs = 0.;              /**< time it took to produce the sheet that is drawn */
+    double gpuMs = 0.;              /**< GPU time of the last sheet draw */
+    RetardedStats newton;           /**< solver work of the sheet that is drawn */
+    size_t uploadedBytes = 0;       /**< bytes the last sheet upload sent to the GPU */
+};
+
+/**
+ * @brief The Hud class draws performance numbers and a frame time graph over the scene
+ *
+ * All glyphs are rasterized once into an atlas texture. Every update()
+ * writes the text and the graph as quads into one dynamic vertex buffer,
+ * which draw() renders with a single draw call. Positions are in pixels
+ * from the top left corner of the viewport.
+ */
+class Hud : public Drawable
+{
+public:
+    Hud(std::string name = "HUD");
+
+    /**
+     * @see Drawable::init()
+     */
+    virtual void init() override;
+
+    /**
+     * @see Drawable::draw(glm::mat4)
+     */
+    virtual void draw(glm::mat4 projection_matrix) const override;
+
+    /**
+     * @brief update Records the frame time and rebuilds the vertex buffer
+     * @param elapsedTimeMs the time since the last frame
+     * @param modelViewMatrix unused, the HUD is drawn in screen space
+     */
+    virtual void update(float elapsedTimeMs, glm::mat4 modelViewMatrix) override;
+
+    /**
+     * @brief setStats sets the numbers shown by the next update()
+     */
+    void setStats(const HudStats& stats);
+
+    /**
+     * @brief setVisible shows or hides the HUD, a hidden HUD only records frame times
+     */
+    void setVisible(bool visible);
+
+    /**
+     * @brief isVisible Getter for whether the HUD is drawn
+     */
+    bool isVisible() const;
+
+protected:
+
+    /**
+     * @see Drawable::getVertexShader()
+     */
+    virtual std::string getVertexShader() const override;
+
+    /**
+     * @see Drawable::getFragmentShader()
+     */
+    virtual std::string getFragmentShader() const override;
+
+    /**
+     * @see Drawable::createObject()
+     */
+    virtual void createObject() override;
+
+    /**
+     * @brief loadTexture rasterizes the glyph atlas
+     *
+     * The printable ASCII characters are drawn with the fixed system font
+     * into a grid of 16 x 6 cells. The cell of DEL (127) is filled white,
+     * the solid quads of the graph sample it.
+     */
+    virtual GLuint loadTexture() override;
+
+    /**
+     * @brief The HudVertex struct is one vertex of a text or graph quad
+     */
+    struct HudVertex
+    {
+        glm::vec2 position;     /**< in pixels from the top left corner */
+        glm::vec2 texCoord;     /**< in the glyph atlas */
+        glm::u8vec4 color;
+    };
+
+    void quad(float x0, float y0, float x1, float y1, glm::vec2 st0, glm::vec2 st1, glm::u8vec4 color);
+    void solid(float x0, float y0, float x1, float y1, glm::u8vec4 color);
+    void text(float x, float y, const char* line, glm::u8vec4 color);
+
+    static const int atlasColumns = 16;
+    static const int atlasRows = 6;
+    static const int historySize = 240;     /**< frame times in the graph */
+
+    int cellWidth;              /**< size of one glyph in pixels */
+    int cellHeight;
+
+    GLuint vertexBuffer;
+    GLsizei vertexCount;        /**< vertices in vertexBuffer */
+    std::vector<HudVertex> vertices;
+
+    std::vector<float> frameTimes;  /**< ring of the last historySize frame times in ms */
+    int nextFrame;              /**< slot of the next frame time */
+    HudStats stats;
+    double buildMs;             /**< time the last update() took */
+    bool visible;
+};
+
+#endif // HUD_H
@@ -7,6 +7,8 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "util/trace.h"
+
 #include <algorithm>
 #include <iostream>
 #include <stack>
@@ -37,7 +39,8 @@ Planet::Planet(std::string name,
     _orbphase(orbphase),
     _localRotation(orbphase),
     _spin(spin),
-    _globalRotation(0)
+    _globalRotation(0),
+    _orbitFromFrame(false)
 {
     _spin = spin; // for local rotation:one step equals one hour
     _orbfreq = orbfreq; // for global rotation
@@ -67,6 +70,7 @@ void Planet::recreate()
 
 void Planet::draw(glm::mat4 projection_matrix) const
 {
+    TRACE_SCOPE("Planet::draw");
 
     if(_program == 0){
         std::cerr << "Planet" << _name << "not initialized. Call init() first." << std::endl;
@@ -122,6 +126,7 @@ void Planet::draw(glm::mat4 projection_matrix) const
 
 void Planet::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
 {
+    TRACE_SCOPE("Planet::update");
 
     float time = elapsedTimeMs/1000.;
     ///TODO: calculate global rotation_modelViewMatrix
@@ -137,7 +142,8 @@ void Planet::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
     while(_localRotation < 0.0f)
         _localRotation += 4*M_PI_2;
 
-    _globalRotation += time *_orbfreq;
+    if(!_orbitFromFrame)
+        _globalRotation += time *_orbfreq;
 
     while(_globalRotation >= 4*M_PI_2)
         _globalRotation -= 4*M_PI_2;
@@ -165,6 +171,13 @@ void Planet::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
     modelview_stack.pop();
 }
 
+void Planet::setOrbitPosition(glm::vec2 position)
+{
+    // the orbit starts at _orbphase, rotating by _globalRotation moves it to the position
+    _globalRotation = std::atan2(position.x, position.y) - _orbphase;
+    _orbitFromFrame = true;
+}
+
 GLuint Planet::loadTexture()
 {
     glGenTextures(1,&textureID);
@@ -7,6 +7,7 @@
 #include <memory>
 #include <vector>
 #include <stack>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 
@@ -46,6 +47,15 @@ public:
 
     void setCameraPosition(glm::vec3 camera);
 
+    /**
+     * @brief setOrbitPosition places the planet on its orbit
+     * @param position the xz position, e.g. a body position of a SpacetimeFrame
+     *
+     * From then on update() only spins the planet, so it stays in sync
+     * with the frame of the spacetime sheet that is drawn.
+     */
+    void setOrbitPosition(glm::vec2 position);
+
     ~Planet();
 
     int triangles;
@@ -65,6 +75,7 @@ protected:
     float _spin;  /**< the speed at which the planet spins */
     float _globalRotation;
     float _globalRotationSpeed;  /**< the speed at which the planet spins around parent*/
+    bool _orbitFromFrame;        /**< the orbit is set by setOrbitPosition() instead of advanced by update() */
 
     std::string _textureLocation;
 
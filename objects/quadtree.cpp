@@ -0,0 +1,368 @@
+#include "objects/quadtree.h"
+
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+Quadtree::Quadtree(int maxLevel, int minLevel)
+    : _maxLevel(maxLevel), _minLevel(minLevel), _side(1 << maxLevel), _frame(0), _evaluations(0)
+{
+    int points = (_side + 1)*(_side + 1);
+    _height.assign(points, 0.f);
+    _stamp.assign(points, 0);
+    for(auto & cache : _retardedTimes)
+        cache.assign(points, -1.f);
+
+    // uniform tree down to the coarsest leaf level
+    _nodes.push_back({0, 0, 0, -1, -1});
+    for(int level = 0; level < _minLevel; ++level)
+    {
+        collectLeaves();
+        for(int leaf : _leaves)
+            split(leaf);
+    }
+    collectLeaves();
+}
+
+void
+Quadtree::update(const Evaluator& evaluate, float tolerance, int passes)
+{
+    ++_frame;
+    _evaluations = 0;
+
+    collectLeaves();
+    evaluateMissing(evaluate);
+
+    for(int pass = 0; pass < passes; ++pass)
+    {
+        bool changed = false;
+
+        // split inaccurate leaves
+        std::vector<int> leaves = _leaves;
+        for(int leaf : leaves)
+        {
+            if(_nodes[leaf].level < _maxLevel && error(_nodes[leaf]) > tolerance)
+            {
+                split(leaf);
+                changed = true;
+            }
+        }
+
+        // merge siblings whose parent is accurate enough, a quarter of the
+        // tolerance keeps cells from flickering between two levels
+        for(int leaf : leaves)
+        {
+            int parent = _nodes[leaf].parent;
+            if(parent < 0 || _nodes[parent].child != leaf || _nodes[parent].level < _minLevel)
+                continue;
+
+            bool siblingsAreLeaves = true;
+            for(int c = 0; c < 4; ++c)
+                siblingsAreLeaves = siblingsAreLeaves && _nodes[leaf + c].child < 0;
+
+            if(siblingsAreLeaves && error(_nodes[parent]) < 0.25f*tolerance && canMerge(parent))
+            {
+                merge(parent);
+                changed = true;
+            }
+        }
+
+        if(!changed)
+            break;
+
+        balance();
+        collectLeaves();
+        evaluateMissing(evaluate);
+    }
+}
+
+void
+Quadtree::collectLeaves()
+{
+    _leaves.clear();
+
+    std::vector<int> stack(1, 0);
+    while(!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+
+        if(_nodes[node].child < 0)
+            _leaves.push_back(node);
+        else
+            for(int c = 0; c < 4; ++c)
+                stack.push_back(_nodes[node].child + c);
+    }
+}
+
+int
+Quadtree::findLeaf(int i, int j) const
+{
+    if(i < 0 || j < 0 || i >= _side || j >= _side)
+        return -1;
+
+    int node = 0;
+    while(_nodes[node].child >= 0)
+    {
+        const Node& n = _nodes[node];
+        int half = size(n)/2;
+        node = n.child + (i >= n.i + half ? 1 : 0) + (j >= n.j + half ? 2 : 0);
+    }
+    return node;
+}
+
+void
+Quadtree::split(int node)
+{
+    int first;
+    if(!_freeBlocks.empty())
+    {
+        first = _freeBlocks.back();
+        _freeBlocks.pop_back();
+    }
+    else
+    {
+        first = _nodes.size();
+        _nodes.resize(first + 4);
+    }
+
+    Node n = _nodes[node];
+    int half = size(n)/2;
+
+    // children: 0 = (x0, z0), 1 = (x1, z0), 2 = (x0, z1), 3 = (x1, z1)
+    for(int c = 0; c < 4; ++c)
+        _nodes[first + c] = {n.i + (c & 1)*half, n.j + (c >> 1)*half, n.level + 1, -1, node};
+
+    _nodes[node].child = first;
+}
+
+void
+Quadtree::merge(int node)
+{
+    _freeBlocks.push_back(_nodes[node].child);
+    _nodes[node].child = -1;
+}
+
+bool
+Quadtree::canMerge(int node) const
+{
+    // after the merge all neighbours have to be at most one level finer
+    const Node& n = _nodes[node];
+    int s = size(n);
+    if(s < 4)
+        return true;
+
+    for(int k = 0; k < 4; ++k)
+    {
+        int offset = k*s/4;
+        int samples[4][2] = {{n.i - 1, n.j + offset}, {n.i + s, n.j + offset},
+                             {n.i + offset, n.j - 1}, {n.i + offset, n.j + s}};
+        for(auto & sample : samples)
+        {
+            int neighbour = findLeaf(sample[0], sample[1]);
+            if(neighbour >= 0 && _nodes[neighbour].level > n.level + 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+float
+Quadtree::error(const Node& node) const
+{
+    // deviation of the center from the bilinear interpolation of the corners
+    int s = size(node);
+    float corners = _height[lattice(node.i, node.j)] + _height[lattice(node.i + s, node.j)]
+                  + _height[lattice(node.i, node.j + s)] + _height[lattice(node.i + s, node.j + s)];
+
+    return std::abs(_height[lattice(node.i + s/2, node.j + s/2)] - 0.25f*corners);
+}
+
+void
+Quadtree::balance()
+{
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        collectLeaves();
+
+        for(int leaf : _leaves)
+        {
+            Node n = _nodes[leaf];
+            int s = size(n);
+
+            // a coarser neighbour covers the whole edge, one sample per edge is enough
+            int samples[4][2] = {{n.i - 1, n.j}, {n.i + s, n.j}, {n.i, n.j - 1}, {n.i, n.j + s}};
+            for(auto & sample : samples)
+            {
+                int neighbour = findLeaf(sample[0], sample[1]);
+                if(neighbour >= 0 && _nodes[neighbour].level < n.level - 1)
+                {
+                    split(neighbour);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void
+Quadtree::evaluateMissing(const Evaluator& evaluate)
+{
+    std::vector<int> points;
+    auto need = [this, &points](int i, int j)
+    {
+        int k = lattice(i, j);
+        if(_stamp[k] != _frame)
+        {
+            _stamp[k] = _frame;
+            points.push_back(k);
+        }
+    };
+
+    for(int leaf : _leaves)
+    {
+        const Node& n = _nodes[leaf];
+        int s = size(n);
+        need(n.i, n.j);
+        need(n.i + s, n.j);
+        need(n.i, n.j + s);
+        need(n.i + s, n.j + s);
+        if(s > 1)
+            need(n.i + s/2, n.j + s/2);
+    }
+
+    if(points.empty())
+        return;
+
+    int count = points.size();
+    std::vector<float> x(count), z(count), potential(count), delta_t0(count), delta_t1(count);
+    for(int p = 0; p < count; ++p)
+    {
+        x[p] = -1 + 2*float(points[p] % (_side + 1))/_side;
+        z[p] = -1 + 2*float(points[p] / (_side + 1))/_side;
+        delta_t0[p] = _retardedTimes[0][points[p]];
+        delta_t1[p] = _retardedTimes[1][points[p]];
+    }
+
+    evaluate(x.data(), z.data(), potential.data(), count, delta_t0.data(), delta_t1.data());
+
+    for(int p = 0; p < count; ++p)
+    {
+        _height[points[p]] = potential[p];
+        _retardedTimes[0][points[p]] = delta_t0[p];
+        _retardedTimes[1][points[p]] = delta_t1[p];
+    }
+
+    _evaluations += count;
+}
+
+bool
+Quadtree::hangingVertex(const Node& leaf, int edge) const
+{
+    // edges: 0 = x0, 1 = z0, 2 = x1, 3 = z1
+    int s = size(leaf);
+    if(s < 2)
+        return false;
+
+    int samples[4][2] = {{leaf.i - 1, leaf.j + s/2}, {leaf.i + s/2, leaf.j - 1},
+                         {leaf.i + s, leaf.j + s/2}, {leaf.i + s/2, leaf.j + s}};
+
+    int neighbour = findLeaf(samples[edge][0], samples[edge][1]);
+    return neighbour >= 0 && _nodes[neighbour].level > leaf.level;
+}
+
+void
+Quadtree::triangulate(float scalefactor, std::vector<SheetVertex>& vertices, std::vector<unsigned int>& indices) const
+{
+    vertices.clear();
+    indices.clear();
+
+    std::vector<int> index((_side + 1)*(_side + 1), -1);
+    auto vertex = [&](int i, int j) -> unsigned int
+    {
+        int k = lattice(i, j);
+        if(index[k] < 0)
+        {
+            index[k] = vertices.size();
+
+            SheetVertex v;
+            v.texCoord = glm::vec2(i, j)/float(_side);
+            v.gridpos = scalefactor*(2.f*v.texCoord - 1.f);
+            v.normal = glm::vec3(0.f);
+            v.height = scalefactor*_height[k];
+            vertices.push_back(v);
+        }
+        return index[k];
+    };
+
+    for(int leaf : _leaves)
+    {
+        const Node& n = _nodes[leaf];
+        int s = size(n);
+
+        unsigned int c0 = vertex(n.i, n.j);
+        unsigned int c1 = vertex(n.i + s, n.j);
+        unsigned int c2 = vertex(n.i + s, n.j + s);
+        unsigned int c3 = vertex(n.i, n.j + s);
+
+        bool hanging[4];
+        for(int edge = 0; edge < 4; ++edge)
+            hanging[edge] = hangingVertex(n, edge);
+
+        if(!hanging[0] && !hanging[1] && !hanging[2] && !hanging[3])
+        {
+            // same triangles as the uniform grid
+            unsigned int quad[6] = {c0, c3, c1, c1, c3, c2};
+            indices.insert(indices.end(), quad, quad + 6);
+            continue;
+        }
+
+        // fan around the center through all corners and hanging vertices
+        std::vector<unsigned int> ring;
+        ring.push_back(c0);
+        if(hanging[0]) ring.push_back(vertex(n.i, n.j + s/2));
+        ring.push_back(c3);
+        if(hanging[3]) ring.push_back(vertex(n.i + s/2, n.j + s));
+        ring.push_back(c2);
+        if(hanging[2]) ring.push_back(vertex(n.i + s, n.j + s/2));
+        ring.push_back(c1);
+        if(hanging[1]) ring.push_back(vertex(n.i + s/2, n.j));
+
+        unsigned int center = vertex(n.i + s/2, n.j + s/2);
+        for(size_t k = 0; k < ring.size(); ++k)
+        {
+            indices.push_back(center);
+            indices.push_back(ring[k]);
+            indices.push_back(ring[(k + 1) % ring.size()]);
+        }
+    }
+
+    // area weighted vertex normals
+    for(size_t t = 0; t < indices.size(); t += 3)
+    {
+        SheetVertex* v[3] = {&vertices[indices[t]], &vertices[indices[t+1]], &vertices[indices[t+2]]};
+        glm::vec3 p[3];
+        for(int k = 0; k < 3; ++k)
+            p[k] = glm::vec3(v[k]->gridpos.x, v[k]->height, v[k]->gridpos.y);
+
+        glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        for(int k = 0; k < 3; ++k)
+            v[k]->normal += normal;
+    }
+    for(auto & v : vertices)
+        v.normal = glm::normalize(v.normal);
+}
+
+int
+Quadtree::evaluations() const
+{
+    return _evaluations;
+}
+
+int
+Quadtree::leafCount() const
+{
+    return _leaves.size();
+}
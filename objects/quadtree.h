@@ -0,0 +1,121 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include <functional>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+/**
+ * @brief The SheetVertex struct is one vertex of the adaptive sheet
+ *
+ * The layout matches the attributes of spacetime.vs.glsl.
+ */
+struct SheetVertex
+{
+    glm::vec2 gridpos;
+    glm::vec2 texCoord;
+    glm::vec3 normal;
+    float height;
+};
+
+/**
+ * @brief The Quadtree class is a restricted quadtree over the sheet [-1, 1]^2
+ *
+ * A leaf is split when the potential at its center differs from the
+ * bilinear interpolation of its corners by more than the tolerance, and
+ * four sibling leaves are merged when their parent is accurate enough.
+ * Neighbouring leaves differ by at most one level (2:1 balance), edges
+ * with a hanging vertex are triangulated as a fan around the cell center,
+ * so the mesh has no cracks.
+ *
+ * The tree lives on a lattice of (2^maxLevel + 1)^2 points. Every update
+ * evaluates the potential only at the corners and centers of the leaves
+ * and adapts the tree by one level, so it follows the moving stars
+ * incrementally.
+ */
+class Quadtree
+{
+public:
+    /**
+     * @brief Evaluator evaluates the potential at count points
+     *
+     * Called as evaluate(x, z, potential, count, delta_t0, delta_t1),
+     * the retarded times are initial guesses and receive the solutions.
+     */
+    typedef std::function<void(const float*, const float*, float*, int, float*, float*)> Evaluator;
+
+    /**
+     * @brief Quadtree constructor
+     * @param maxLevel the finest level, its cells have a size of 2/2^maxLevel
+     * @param minLevel the coarsest level of the leaves
+     */
+    Quadtree(int maxLevel = 9, int minLevel = 4);
+
+    /**
+     * @brief update evaluates the potential and adapts the tree
+     * @param evaluate the potential
+     * @param tolerance the allowed interpolation error of the potential
+     * @param passes the number of refinement passes (more than one to build a fresh tree)
+     */
+    void update(const Evaluator& evaluate, float tolerance, int passes = 1);
+
+    /**
+     * @brief triangulate creates the crack-free mesh of the leaves
+     * @param scalefactor scales positions and heights
+     * @param vertices receives the vertices
+     * @param indices receives three indices per triangle
+     */
+    void triangulate(float scalefactor, std::vector<SheetVertex>& vertices, std::vector<unsigned int>& indices) const;
+
+    /**
+     * @brief evaluations Getter for the number of potential evaluations of the last update
+     * @return the number of evaluated lattice points
+     */
+    int evaluations() const;
+
+    /**
+     * @brief leafCount Getter for the number of leaves
+     * @return the number of leaves
+     */
+    int leafCount() const;
+
+private:
+    struct Node
+    {
+        int i, j;   /**< lower corner on the lattice */
+        int level;
+        int child;  /**< index of the first of four children, -1 for leaves */
+        int parent;
+    };
+
+    int _maxLevel;
+    int _minLevel;
+    int _side;                      /**< lattice cells per side, 2^maxLevel */
+
+    std::vector<Node> _nodes;
+    std::vector<int> _freeBlocks;   /**< unused blocks of four nodes */
+    std::vector<int> _leaves;
+
+    std::vector<float> _height;     /**< potential on the lattice */
+    std::vector<float> _retardedTimes[2]; /**< solved delta_t on the lattice, guesses for the next update */
+    std::vector<unsigned int> _stamp;     /**< update in which a lattice point was evaluated */
+    unsigned int _frame;
+    int _evaluations;
+
+    int size(const Node& node) const { return _side >> node.level; }
+    int lattice(int i, int j) const { return i + j*(_side + 1); }
+
+    void collectLeaves();
+    int findLeaf(int i, int j) const;
+    void split(int node);
+    void merge(int node);
+    bool canMerge(int node) const;
+    float error(const Node& node) const;
+    void balance();
+    void evaluateMissing(const Evaluator& evaluate);
+    bool hangingVertex(const Node& leaf, int edge) const;
+};
+
+#endif // QUADTREE_H
@@ -0,0 +1,98 @@
+#include "objects/simulation.h"
+
+#include "util/trace.h"
+
+#include <chrono>
+#include <cmath>
+
+Simulation::Simulation(std::shared_ptr<Spacetime> spacetime, float periodMs) :
+    _spacetime(spacetime), _running(false), _periodMs(periodMs), _time(0.f)
+{
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void
+Simulation::start(float time)
+{
+    if(_running)
+        return;
+
+    _time = time;
+    _running = true;
+    _thread = std::thread(&Simulation::run, this);
+}
+
+float
+Simulation::stop()
+{
+    _running = false;
+    if(_thread.joinable())
+        _thread.join();
+
+    return _time;
+}
+
+void
+Simulation::refresh()
+{
+    if(_running)
+        return;
+
+    _spacetime->produceFrame(_frames.back(), _time);
+    _frames.publish();
+}
+
+bool
+Simulation::isRunning() const
+{
+    return _running;
+}
+
+bool
+Simulation::acquire()
+{
+    return _frames.acquire();
+}
+
+const SpacetimeFrame&
+Simulation::frame() const
+{
+    return _frames.front();
+}
+
+void
+Simulation::setPeriod(float periodMs)
+{
+    _periodMs = periodMs;
+}
+
+void
+Simulation::run()
+{
+    typedef std::chrono::steady_clock clock;
+
+    Trace::setThreadName("simulation");
+
+    clock::time_point last = clock::now();
+    double accumulatedMs = 0.;
+    while(_running)
+    {
+        clock::time_point start = clock::now();
+        accumulatedMs += std::chrono::duration<double, std::milli>(start - last).count();
+        last = start;
+
+        double steps = std::floor(accumulatedMs/stepMs);
+        accumulatedMs -= steps*stepMs;
+        _time += float(steps*stepMs/1000.);
+
+        _spacetime->produceFrame(_frames.back(), _time);
+        _frames.publish();
+
+        std::chrono::duration<float, std::milli> period(_periodMs.load());
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(period));
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "objects/spacetime.h"
+#include "util/triplebuffer.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief The Simulation class produces spacetime frames on its own thread
+ *
+ * The thread advances the simulation time by the monotonic clock in whole
+ * steps of stepMs, carrying the rest over to the next frame, computes a
+ * frame with Spacetime::produceFrame() and publishes it into a triple
+ * buffer, at most once per period. The widget picks up the latest
+ * complete frame with acquire() and uploads it, so a slow potential
+ * evaluation never blocks input handling or the buffer swap, and the
+ * sheet is simulated at its own rate independently of the frame rate.
+ */
+class Simulation
+{
+public:
+    static constexpr float stepMs = 1000.f/240.f;   /**< the simulation time advances in multiples of this */
+
+    /**
+     * @brief Simulation constructor
+     * @param spacetime the sheet to simulate, it must not be produced by anyone else while running
+     * @param periodMs minimal time between two frames, 0 produces frames as fast as possible
+     */
+    explicit Simulation(std::shared_ptr<Spacetime> spacetime, float periodMs = 1000.f/60.f);
+
+    /**
+     * @brief ~Simulation stops the thread
+     */
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * @brief start starts the thread
+     * @param time the simulation time of the first frame
+     */
+    void start(float time = 0.f);
+
+    /**
+     * @brief stop stops the thread after its current frame
+     * @return the simulation time of the last frame
+     */
+    float stop();
+
+    /**
+     * @brief refresh produces one frame at the current simulation time on the calling thread
+     *
+     * Used while the thread is stopped, e.g. when the animation is paused
+     * and a parameter of the sheet changed. Ignored while it runs.
+     */
+    void refresh();
+
+    /**
+     * @brief isRunning Getter for the state of the thread
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief acquire picks up the latest complete frame
+     * @return true if frame() changed since the last call
+     */
+    bool acquire();
+
+    /**
+     * @brief frame Getter for the frame picked up by acquire()
+     */
+    const SpacetimeFrame& frame() const;
+
+    /**
+     * @brief setPeriod sets the minimal time between two frames
+     * @param periodMs the period in ms, 0 produces frames as fast as possible
+     */
+    void setPeriod(float periodMs);
+
+private:
+    void run();
+
+    std::shared_ptr<Spacetime> _spacetime;
+    TripleBuffer<SpacetimeFrame> _frames;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<float> _periodMs;
+    float _time;    /**< simulation time, owned by the thread while it runs */
+};
+
+#endif // SIMULATION_H
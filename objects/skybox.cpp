@@ -11,6 +11,8 @@
 
 #include "glbase/texload.hpp"
 
+#include "util/trace.h"
+
 #include <iostream>
 #include <stack>
 
@@ -30,6 +32,7 @@ void Skybox::init()
 
 void Skybox::draw(glm::mat4 projection_matrix) const
 {
+    TRACE_SCOPE("Skybox::draw");
 
     glDepthMask(GL_FALSE);
 
@@ -62,6 +65,7 @@ void Skybox::draw(glm::mat4 projection_matrix) const
 
 void Skybox::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
 {
+    TRACE_SCOPE("Skybox::update");
 
     //take out any unwanted translation from modelview matrix
     glm::mat4 view = glm::mat4(glm::mat3(modelViewMatrix));
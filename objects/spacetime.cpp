@@ -9,6 +9,8 @@
 #include <iostream>
 #include <stack>
 #include <cmath>
+#include <chrono>
+#include <cstddef>
 
 #include <QFile>
 #include <QTextStream>
@@ -20,22 +22,28 @@
 #include "glbase/texload.hpp"
 
 #include "gui/config.h"
-
-Spacetime::Spacetime(std::string name, std::string textureLocation): Drawable(name)
+#include "util/trace.h"
+
+Spacetime::Spacetime(std::string name, std::string textureLocation): Drawable(name),
+    gridBuffer(0), indexBuffer(0), streamBuffer(0), streamMapping(nullptr),
+    streamRegionSize(0), streamRegion(0), gridSide(-1),
+    pool(new ThreadPool()), simSide(0),
+    farFieldTolerance(1e-5f), potentialModel(eModelNewtonian),
+    renderPath(ePathStreamed), curvatureColouring(true), activePath(ePathStreamed), shownTime(0.f), shownAge(0.f), shownCpuMs(0.), uploadedBytes(0), hasFrame(false),
+    corotProgram(0), fieldTexture(0), fieldAngles(1024), fieldRadii(512), fieldRadius(std::sqrt(2.f)),
+    heightProgram(0), heightTexture(0), heightUnpackBuffer(0),
+    tessProgram(0), patchVertexArray(0), patchBuffer(0), patchSide(32),
+    quadtreeTolerance(1e-3f), quadtreeVertexArray(0), quadtreeVertexBuffer(0), quadtreeIndexBuffer(0),
+    quadtreeIndexCount(0)
 {
     _textureLocation=textureLocation;
     time = 0.f;
+    clockTime = 0.f;
+
+    scalefactor = 1.0;
+    nside = 150;
 
-    c_light_fraction = 0.8;
-    omega = 4*M_PI_2/15.;
-    R_N0 = 0.02;
-    R_N1 = 0.02;
-    gravConst = 1;
-    density = 500;
-    separation = 0.1;
-    GM0 = gravConst*density*(4./3.)*2*M_PI_2*std::pow(R_N0, 3);
-    GM1 = gravConst*density*(4./3.)*2*M_PI_2*std::pow(R_N1, 3);
-    c_light = omega*separation/(2*c_light_fraction);
+    for(auto & fence : streamFences) fence = 0;
 }
 
 void
@@ -46,49 +54,174 @@ Spacetime::init()
     loadFBO();
 
     loadTexture();
+
+    corotProgram = createProgram(":/shader/spacetime_corot.vs.glsl");
+    heightProgram = createProgram(":/shader/spacetime_height.vs.glsl");
+    tessProgram = createProgram(":/shader/spacetime_tess.vs.glsl", ":/shader/spacetime.tcs.glsl", ":/shader/spacetime.tes.glsl");
+
+    glGenTextures(1, &fieldTexture);
+    glBindTexture(GL_TEXTURE_2D, fieldTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    VERIFY(CG::checkError());
+}
+
+GLuint
+Spacetime::createProgram(std::string vertexShaderPath,
+                         std::string tessControlShaderPath, std::string tessEvaluationShaderPath) const
+{
+    // all render paths share the fragment shader
+    GLuint vs = CG::createCompileShader(GL_VERTEX_SHADER, loadShaderFile(vertexShaderPath)); VERIFY(vs);
+    GLuint fs = CG::createCompileShader(GL_FRAGMENT_SHADER, getFragmentShader()); VERIFY(fs);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+
+    if(!tessControlShaderPath.empty())
+    {
+        GLuint tcs = CG::createCompileShader(GL_TESS_CONTROL_SHADER, loadShaderFile(tessControlShaderPath)); VERIFY(tcs);
+        GLuint tes = CG::createCompileShader(GL_TESS_EVALUATION_SHADER, loadShaderFile(tessEvaluationShaderPath)); VERIFY(tes);
+        glAttachShader(program, tcs);
+        glAttachShader(program, tes);
+    }
+
+    program = CG::linkProgram(program);
+
+    VERIFY(program);
+
+    return program;
+}
+
+GLuint
+Spacetime::pathProgram(eRenderPath path) const
+{
+    switch(path)
+    {
+    case ePathCorotating:    return corotProgram;
+    case ePathHeightTexture: return heightProgram;
+    case ePathTessellated:   return tessProgram;
+    default:                 return _program;
+    }
 }
 
 void
 Spacetime::draw(glm::mat4 projection_matrix) const
 {
+    TRACE_SCOPE("Spacetime::draw");
+
+    // nothing to show before the first frame arrived
+    if(!hasFrame)
+        return;
+
+    GLuint program = pathProgram(activePath);
 
     // Load program
-    glUseProgram(_program);
+    glUseProgram(program);
 
     // bind texture
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D,textureID);
 
     // bind vertex array object
-    glBindVertexArray(_vertexArrayObject);
+    if(activePath == ePathTessellated)
+        glBindVertexArray(patchVertexArray);
+    else if(activePath == ePathQuadtree)
+        glBindVertexArray(quadtreeVertexArray);
+    else
+        glBindVertexArray(_vertexArrayObject);
 
     // set parameter
-    glUniformMatrix4fv(glGetUniformLocation(_program, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
-    glUniformMatrix4fv(glGetUniformLocation(_program, "modelview_matrix"), 1, GL_FALSE, glm::value_ptr(_modelViewMatrix));
-    glUniform1i(glGetUniformLocation(_program, "texture"), 0);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
+    glUniformMatrix4fv(glGetUniformLocation(program, "modelview_matrix"), 1, GL_FALSE, glm::value_ptr(_modelViewMatrix));
+    glUniform1i(glGetUniformLocation(program, "texture"), 0);
+    glUniform1i(glGetUniformLocation(program, "curvatureColouring"), curvatureColouring);
+
+    // the keyframed path blends the two keyframes around the time it is shown at, the others draw the first set of attributes
+    int keyframeRegions[2] = {-1, -1};
+    float blend = 0.f;
+    if(activePath == ePathKeyframed)
+    {
+        blend = keyframeBlend(keyframeRegions);
+        if(keyframeRegions[0] < 0)
+        {
+            glBindVertexArray(0);
+            return;
+        }
+        bindStreamRegions(keyframeRegions[0], keyframeRegions[1]);
+    }
+    glUniform1f(glGetUniformLocation(program, "blend"), blend);
+    glUniform1f(glGetUniformLocation(program, "keyframeInterval"), keyframeInterval);
 
+    if(activePath == ePathCorotating)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, fieldTexture);
+        glUniform1i(glGetUniformLocation(program, "field"), 1);
+        glUniform1f(glGetUniformLocation(program, "phase"), std::fmod(double(shownBinary.parameters().omega)*shownTime, 4*M_PI_2));
+        glUniform1f(glGetUniformLocation(program, "fieldRadius"), fieldRadius);
+        glUniform1f(glGetUniformLocation(program, "spacing"), 2.f/gridSide);
+        glUniform1f(glGetUniformLocation(program, "scalefactor"), scalefactor);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
-    VERIFY(CG::checkError());
+    if(activePath == ePathHeightTexture)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, heightTexture);
+        glUniform1i(glGetUniformLocation(program, "heights"), 1);
+        glUniform1f(glGetUniformLocation(program, "spacing"), scalefactor*2.f/gridSide);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
-    //lighting values
-    glm::vec3 La(0.6f);
-    glUniform3fv(glGetUniformLocation(_program, "La"), 1, glm::value_ptr(La));
-    glm::vec3 Ls(1.0, 1.0, 1.0);
-    glUniform3fv(glGetUniformLocation(_program, "Ls"), 1, glm::value_ptr(Ls));
-    glm::vec3 Ld(1.f);
-    glUniform3fv(glGetUniformLocation(_program, "Ld"), 1, glm::value_ptr(Ld));
-    float shininess = 2.f;
-    glUniform1f(glGetUniformLocation(_program, "shininess"), shininess);
-    glm::vec3 kd(1.f);
-    glUniform3fv(glGetUniformLocation(_program, "kd"), 1, glm::value_ptr(kd));
-    glm::vec3 ks(.0f);
-    glUniform3fv(glGetUniformLocation(_program, "ks"), 1, glm::value_ptr(ks));
-    glm::vec3 ka(0.5f);
-    glUniform3fv(glGetUniformLocation(_program, "ka"), 1, glm::value_ptr(ka));
+    if(activePath == ePathTessellated)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glUniform2f(glGetUniformLocation(program, "viewport"), viewport[2], viewport[3]);
+        glUniform1f(glGetUniformLocation(program, "pixelsPerSegment"), 8.f);
+        glUniform1f(glGetUniformLocation(program, "wellGain"), 16.f);
+        glUniform1f(glGetUniformLocation(program, "scalefactor"), scalefactor);
+        setBinaryUniforms(program);
+    }
+
+    VERIFY(CG::checkError());
 
+    setLightingUniforms(program);
 
     // call draw
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    if(activePath == ePathTessellated)
+    {
+        glPatchParameteri(GL_PATCH_VERTICES, 4);
+        glDrawArrays(GL_PATCHES, 0, 4*patchSide*patchSide);
+    }
+    else if(activePath == ePathQuadtree)
+    {
+        glDrawElements(GL_TRIANGLES, quadtreeIndexCount, GL_UNSIGNED_INT, 0);
+    }
+    else
+    {
+        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    }
+
+    // the stream regions that were read may not be overwritten before this draw has finished
+    auto fenceRegion = [this](unsigned int region)
+    {
+        if(streamFences[region])
+            glDeleteSync(streamFences[region]);
+        streamFences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    };
+    if(activePath == ePathStreamed)
+        fenceRegion(streamRegion);
+    if(activePath == ePathKeyframed)
+    {
+        fenceRegion(keyframeRegions[0]);
+        if(keyframeRegions[1] != keyframeRegions[0])
+            fenceRegion(keyframeRegions[1]);
+    }
 
     // unbind vertex array object
     glBindVertexArray(0);
@@ -98,11 +231,65 @@ Spacetime::draw(glm::mat4 projection_matrix) const
 
 }
 
+void
+Spacetime::setBinaryUniforms(GLuint program) const
+{
+    const BinaryParameters& parameters = shownBinary.parameters();
+
+    float phase[2], rho[2], starPos[4], GM[2], starRadius[2];
+    for(int k = 0; k < 2; ++k)
+    {
+        glm::vec2 r = shownBinary.trajectory(shownTime, k);
+        phase[k] = std::fmod(double(parameters.omega)*shownTime + k*2*M_PI_2, 4*M_PI_2);
+        rho[k] = shownBinary.orbitRadius(k);
+        starPos[2*k] = r.x;
+        starPos[2*k+1] = r.y;
+        GM[k] = shownBinary.GM(k);
+        starRadius[k] = shownBinary.bodyRadius(k);
+    }
+
+    glUniform1fv(glGetUniformLocation(program, "phase"), 2, phase);
+    glUniform1fv(glGetUniformLocation(program, "rho"), 2, rho);
+    glUniform1fv(glGetUniformLocation(program, "GM"), 2, GM);
+    glUniform1fv(glGetUniformLocation(program, "starRadius"), 2, starRadius);
+    glUniform2fv(glGetUniformLocation(program, "starPos"), 2, starPos);
+    glUniform1f(glGetUniformLocation(program, "omega"), parameters.omega);
+    glUniform1f(glGetUniformLocation(program, "c_light"), shownBinary.c_light());
+    glUniform1f(glGetUniformLocation(program, "c_light_fraction"), parameters.c_light_fraction);
+    glUniform1i(glGetUniformLocation(program, "potentialModel"), parameters.model);
+    glUniform1f(glGetUniformLocation(program, "yukawaLength"), parameters.yukawaLength);
+    glUniform1i(glGetUniformLocation(program, "solverIterations"), shownBinary.getSolverIterations());
+    glUniform1f(glGetUniformLocation(program, "solverTolerance"), shownBinary.getSolverTolerance());
+}
+
+void
+Spacetime::setLightingUniforms(GLuint program) const
+{
+    //lighting values
+    glm::vec3 La(0.6f);
+    glUniform3fv(glGetUniformLocation(program, "La"), 1, glm::value_ptr(La));
+    glm::vec3 Ls(1.0, 1.0, 1.0);
+    glUniform3fv(glGetUniformLocation(program, "Ls"), 1, glm::value_ptr(Ls));
+    glm::vec3 Ld(1.f);
+    glUniform3fv(glGetUniformLocation(program, "Ld"), 1, glm::value_ptr(Ld));
+    float shininess = 2.f;
+    glUniform1f(glGetUniformLocation(program, "shininess"), shininess);
+    glm::vec3 kd(1.f);
+    glUniform3fv(glGetUniformLocation(program, "kd"), 1, glm::value_ptr(kd));
+    glm::vec3 ks(.0f);
+    glUniform3fv(glGetUniformLocation(program, "ks"), 1, glm::value_ptr(ks));
+    glm::vec3 ka(0.5f);
+    glUniform3fv(glGetUniformLocation(program, "ka"), 1, glm::value_ptr(ka));
+}
+
 void
 Spacetime::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
 {
+    TRACE_SCOPE("Spacetime::update");
+
     _modelViewMatrix = modelViewMatrix;
-    time += elapsedTimeMs/1000.;
+    clockTime += elapsedTimeMs/1000.;
+    shownAge += elapsedTimeMs/1000.f;
 }
 
 std::string
@@ -117,67 +304,714 @@ Spacetime::getFragmentShader() const
     return Drawable::loadShaderFile(":/shader/spacetime.fs.glsl");
 }
 
+void
+Spacetime::recreate()
+{
+    produceFrame(syncFrame, clockTime);
+    uploadFrame(syncFrame);
+}
+
+void
+Spacetime::produceFrame(SpacetimeFrame& frame, float frameTime)
+{
+    TRACE_SCOPE("Spacetime::produceFrame");
+
+    auto start = std::chrono::steady_clock::now();
+
+    time = frameTime;
+    simSide = nside;
+    binary.setFarFieldTolerance(farFieldTolerance);
+    if(binary.parameters().model != potentialModel)
+    {
+        BinaryParameters parameters = binary.parameters();
+        parameters.model = potentialModel;
+        binary.setParameters(parameters);
+    }
+    newtonStats = RetardedStats();
+
+    frame.time = time;
+    frame.side = simSide;
+    frame.bodies[0] = binary.trajectory(time, 0);
+    frame.bodies[1] = binary.trajectory(time, 1);
+    frame.parameters = binary.parameters();
+    frame.solverIterations = binary.getSolverIterations();
+    frame.solverTolerance = binary.getSolverTolerance();
+    frame.grid.clear();
+    frame.meshVertices.clear();
+    frame.meshIndices.clear();
+    frame.field.reset();
+    frame.keyframes.clear();
+
+    eRenderPath path = renderPath;
+
+    // falls back to the streamed path while the binary is not stationary
+    if(path == ePathCorotating && !updateCorotatingField())
+        path = ePathStreamed;
+    frame.path = path;
+
+    // the keyframes are only kept while they are used
+    if(path != ePathKeyframed)
+        keyframes.clear();
+
+    switch(path)
+    {
+    case ePathCorotating:
+        frame.field = field;
+        break;
+    case ePathKeyframed:
+        keyframeFrame(frame);
+        break;
+    case ePathTessellated:
+        // nothing to do on the CPU, the potential is evaluated in the evaluation shader
+        break;
+    case ePathQuadtree:
+        quadtreeFrame(frame);
+        break;
+    default:
+        // the height texture path derives its normals in the vertex shader
+        bool withNormals = (path != ePathHeightTexture);
+        calcPositions(withNormals);
+
+        frame.grid.resize(positions.size());
+        for(size_t k = 0; k < positions.size(); ++k)
+        {
+            frame.grid[k].normal = withNormals ? vertex_normals[k] : glm::vec3(0.f, 1.f, 0.f);
+            frame.grid[k].height = positions[k].y;
+            frame.grid[k].curvature = withNormals ? vertex_curvature[k] : 0.f;
+        }
+    }
+
+    frame.stats = newtonStats;
+    frame.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+Spacetime::uploadFrame(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::uploadFrame");
+
+    uploadedBytes = 0;
+
+    switch(frame.path)
+    {
+    case ePathCorotating:
+        if(gridSide != frame.side)
+            buildGrid(frame.side);
+        uploadField(frame);
+        break;
+    case ePathTessellated:
+        break;
+    case ePathQuadtree:
+        uploadQuadtree(frame);
+        break;
+    case ePathKeyframed:
+        if(gridSide != frame.side)
+            buildGrid(frame.side);
+        uploadKeyframes(frame);
+        break;
+    case ePathHeightTexture:
+        if(gridSide != frame.side)
+            buildGrid(frame.side);
+        heightFrame(frame);
+        break;
+    default:
+        if(gridSide != frame.side)
+            buildGrid(frame.side);
+        streamFrame(frame);
+    }
+
+    // the binary of the producer may change at any time, the draw calls use a copy
+    if(shownBinary.parameters() != frame.parameters)
+        shownBinary.setParameters(frame.parameters);
+    shownBinary.setSolverIterations(frame.solverIterations);
+    shownBinary.setSolverTolerance(frame.solverTolerance);
+
+    activePath = frame.path;
+    shownTime = frame.time;
+    shownAge = 0.f;
+    shownStats = frame.stats;
+    shownCpuMs = frame.cpuMs;
+    hasFrame = true;
+}
+
+const char*
+renderPathName(eRenderPath path)
+{
+    switch(path)
+    {
+    case ePathStreamed:      return "streamed";
+    case ePathCorotating:    return "co-rotating field";
+    case ePathHeightTexture: return "height texture";
+    case ePathTessellated:   return "tessellated";
+    case ePathQuadtree:      return "quadtree";
+    case ePathKeyframed:     return "keyframed";
+    default:                 return "unknown";
+    }
+}
+
+double
+Spacetime::getFrameCpuMs() const
+{
+    return shownCpuMs;
+}
+
+size_t
+Spacetime::getUploadedBytes() const
+{
+    return uploadedBytes;
+}
+
+int
+Spacetime::getNside() const
+{
+    return nside;
+}
+
+void
+Spacetime::setNside(int side)
+{
+    nside = side;
+}
+
+void
+Spacetime::setPotentialModel(ePotentialModel model)
+{
+    potentialModel = model;
+}
+
+ePotentialModel
+Spacetime::getPotentialModel() const
+{
+    return potentialModel;
+}
+
+void
+Spacetime::setCurvatureColouring(bool enabled)
+{
+    curvatureColouring = enabled;
+}
+
+bool
+Spacetime::getCurvatureColouring() const
+{
+    return curvatureColouring;
+}
+
+void
+Spacetime::setRenderPath(eRenderPath path)
+{
+    renderPath = path;
+}
+
+eRenderPath
+Spacetime::getRenderPath() const
+{
+    return renderPath;
+}
+
+eRenderPath
+Spacetime::getActivePath() const
+{
+    return activePath;
+}
+
+std::vector<float>
+Spacetime::binarySignature() const
+{
+    const BinaryParameters& p = binary.parameters();
+    return {p.c_light_fraction, p.omega, p.R_N0, p.R_N1, p.gravConst, p.density, p.separation,
+            float(p.model), p.yukawaLength};
+}
+
+bool
+Spacetime::updateCorotatingField()
+{
+    // For a circular orbit with constant omega the retarded potential is a rigid
+    // rotation of the potential at time 0. While parameters change from frame to
+    // frame the motion is not stationary and the field can not be used.
+    std::vector<float> signature = binarySignature();
+    bool steady = (signature == lastSignature);
+    lastSignature = signature;
+
+    if(signature == fieldSignature)
+        return true;
+    if(!steady)
+        return false;
+
+    calcCorotatingField();
+    fieldSignature = signature;
+    return true;
+}
+
+void
+Spacetime::calcCorotatingField()
+{
+    TRACE_SCOPE("Spacetime::calcCorotatingField");
+
+    std::vector<float> values(fieldAngles*fieldRadii);
+
+    // potential at time 0, i.e. with the bodies at phase 0 and pi
+    pool->parallelFor(0, fieldRadii, 1, [this, &values](int first, int last)
+    {
+        std::vector<float> xpos(fieldAngles);
+        std::vector<float> zpos(fieldAngles);
+
+        for(int j = first; j < last; ++j)
+        {
+            float r = fieldRadius*float(j)/float(fieldRadii - 1);
+            for(int i = 0; i < fieldAngles; ++i)
+            {
+                float angle = 4*M_PI_2*float(i)/float(fieldAngles);
+                xpos[i] = r*std::sin(angle);
+                zpos[i] = r*std::cos(angle);
+            }
+            binary.potentialBatch(0.f, xpos.data(), zpos.data(), &values[j*fieldAngles], fieldAngles);
+        }
+    });
+
+    field = std::make_shared<const std::vector<float>>(std::move(values));
+}
+
+void
+Spacetime::uploadField(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::uploadField");
+
+    if(frame.field == uploadedField)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, fieldTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, fieldAngles, fieldRadii, 0, GL_RED, GL_FLOAT, frame.field->data());
+    uploadedField = frame.field;
+    uploadedBytes += frame.field->size()*sizeof(float);
+
+    VERIFY(CG::checkError());
+}
+
 void
 Spacetime::createObject()
 {
-    positions.clear();
-    indices.clear();
-    vertex_normals.clear();
-    texCoords.clear();
+    buildGrid(nside);
+}
 
-    scalefactor = 1.0;
-    nside = 150;
+void
+Spacetime::buildGrid(int side)
+{
+    TRACE_SCOPE("Spacetime::buildGrid");
 
-    calcPositions();
+    gridSide = side;
+    calcGrid();
 
-    glm::vec3 stcolor = glm::vec3(0,0.5,1);
-    
     // Set up a vertex array object for the geometry
     if(_vertexArrayObject == 0)
       glGenVertexArrays(1, &_vertexArrayObject);
     glBindVertexArray(_vertexArrayObject);
 
-
-    // fill vertex array object with data
-    GLuint position_buffer;
-    glGenBuffers(1, &position_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, position_buffer);
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * 3 * sizeof(float), positions.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    // static part: xz positions and texture coordinates are uploaded once per resolution
+    std::vector<glm::vec2> gridData;
+    gridData.reserve(2*texCoords.size());
+    for(auto & tex : texCoords)
+        gridData.push_back(scalefactor*(2.f*tex - 1.f));
+    gridData.insert(gridData.end(), texCoords.begin(), texCoords.end());
+
+    if(gridBuffer == 0)
+        glGenBuffers(1, &gridBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+    glBufferData(GL_ARRAY_BUFFER, gridData.size()*sizeof(glm::vec2), gridData.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_TRUE, 0, (void*)(texCoords.size()*sizeof(glm::vec2)));
+    glEnableVertexAttribArray(2);
 
-    GLuint index_buffer;
-    glGenBuffers(1, &index_buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    if(indexBuffer == 0)
+        glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    uploadedBytes += gridData.size()*sizeof(glm::vec2) + indices.size()*sizeof(unsigned int);
 
-    GLuint normal_buffer;
-    glGenBuffers(1, &normal_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, normal_buffer);
-    glBufferData(GL_ARRAY_BUFFER, vertex_normals.size() * 3 * sizeof(float), vertex_normals.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_TRUE, 0, 0);
-    glEnableVertexAttribArray(1);
-
-    GLuint tex_buffer;
-    glGenBuffers(1,&tex_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, tex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, texCoords.size()*sizeof (glm::vec2),texCoords.data(),GL_STATIC_DRAW);
-    glVertexAttribPointer(2,2,GL_FLOAT,GL_TRUE,0,0);
-    glEnableVertexAttribArray(2);
+    // dynamic part: a ring of streamRegions regions holding heights and normals, followed by the height rates of a keyframe
+    for(auto & fence : streamFences)
+    {
+        if(fence)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    if(streamBuffer != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+        if(streamMapping)
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &streamBuffer);
+        streamMapping = nullptr;
+    }
+
+    streamRegionSize = texCoords.size()*(sizeof(StreamVertex) + sizeof(float));
+    glGenBuffers(1, &streamBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    if(GLEW_ARB_buffer_storage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, streamRegions*streamRegionSize, nullptr, flags);
+        streamMapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, streamRegions*streamRegionSize, flags);
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, streamRegions*streamRegionSize, nullptr, GL_STREAM_DRAW);
+    }
+    for(auto & keyframe : regionKeyframes)
+        keyframe.reset();
+
+    // the dynamic attributes are pointed into the ring by bindStreamRegions() once a region is filled
 
     // unbind vertex array object
     glBindVertexArray(0);
 
-    // delete buffers (the data is stored in the vertex array object)
-    glDeleteBuffers(1, &position_buffer);
-    glDeleteBuffers(1, &index_buffer);
-    glDeleteBuffers(1, &normal_buffer); // ok to delete?
-    glDeleteBuffers(1,&tex_buffer);
+    // height texture path: one float per vertex
+    if(heightTexture == 0)
+    {
+        glGenTextures(1, &heightTexture);
+        glGenBuffers(1, &heightUnpackBuffer);
+    }
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, gridSide+1, gridSide+1, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // tessellation path: four corners per patch
+    std::vector<glm::vec2> patches;
+    for(int j = 0; j < patchSide; ++j)
+    {
+        for(int i = 0; i < patchSide; ++i)
+        {
+            float x0 = -1 + 2*float(i)/patchSide, x1 = -1 + 2*float(i+1)/patchSide;
+            float z0 = -1 + 2*float(j)/patchSide, z1 = -1 + 2*float(j+1)/patchSide;
+            patches.push_back(scalefactor*glm::vec2(x0, z0));
+            patches.push_back(scalefactor*glm::vec2(x1, z0));
+            patches.push_back(scalefactor*glm::vec2(x1, z1));
+            patches.push_back(scalefactor*glm::vec2(x0, z1));
+        }
+    }
+    if(patchVertexArray == 0)
+    {
+        glGenVertexArrays(1, &patchVertexArray);
+        glGenBuffers(1, &patchBuffer);
+    }
+    glBindVertexArray(patchVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, patchBuffer);
+    glBufferData(GL_ARRAY_BUFFER, patches.size()*sizeof(glm::vec2), patches.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    streamRegion = 0;
 
     // check for errors
     VERIFY(CG::checkError());
 }
 
+void
+Spacetime::quadtreeFrame(SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::quadtreeFrame");
+
+    // blocks of points on the thread pool, warm started from the retarded times on the lattice
+    Quadtree::Evaluator evaluate = [this](const float* x, const float* z, float* potential, int count,
+                                          float* delta_t0, float* delta_t1)
+    {
+        pool->parallelFor(0, count, 256, [&](int first, int last)
+        {
+            RetardedStats stats;
+            binary.potentialBatch(time, x + first, z + first, potential + first, last - first,
+                                  delta_t0 + first, delta_t1 + first, &stats);
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+            newtonStats += stats;
+        });
+    };
+
+    // a fresh tree is refined down to its finest level at once
+    if(!quadtree)
+    {
+        quadtree.reset(new Quadtree());
+        quadtree->update(evaluate, quadtreeTolerance, 16);
+    }
+    else
+    {
+        quadtree->update(evaluate, quadtreeTolerance);
+    }
+
+    quadtree->triangulate(scalefactor, frame.meshVertices, frame.meshIndices);
+}
+
+void
+Spacetime::uploadQuadtree(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::uploadQuadtree");
+
+    quadtreeIndexCount = frame.meshIndices.size();
+
+    if(quadtreeVertexArray == 0)
+    {
+        glGenVertexArrays(1, &quadtreeVertexArray);
+        glGenBuffers(1, &quadtreeVertexBuffer);
+        glGenBuffers(1, &quadtreeIndexBuffer);
+
+        glBindVertexArray(quadtreeVertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, quadtreeVertexBuffer);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SheetVertex), (void*)offsetof(SheetVertex, gridpos));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_TRUE, sizeof(SheetVertex), (void*)offsetof(SheetVertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_TRUE, sizeof(SheetVertex), (void*)offsetof(SheetVertex, texCoord));
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SheetVertex), (void*)offsetof(SheetVertex, height));
+        for(GLuint attribute = 0; attribute < 4; ++attribute)
+            glEnableVertexAttribArray(attribute);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadtreeIndexBuffer);
+    }
+    else
+    {
+        glBindVertexArray(quadtreeVertexArray);
+    }
+
+    // the topology changes every frame, so the buffers are respecified
+    glBindBuffer(GL_ARRAY_BUFFER, quadtreeVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, frame.meshVertices.size()*sizeof(SheetVertex), frame.meshVertices.data(), GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, frame.meshIndices.size()*sizeof(unsigned int), frame.meshIndices.data(), GL_STREAM_DRAW);
+    uploadedBytes += frame.meshVertices.size()*sizeof(SheetVertex) + frame.meshIndices.size()*sizeof(unsigned int);
+
+    glBindVertexArray(0);
+
+    VERIFY(CG::checkError());
+}
+
+void
+Spacetime::heightFrame(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::heightFrame");
+
+    GLsizeiptr size = frame.grid.size()*sizeof(float);
+
+    // orphan the unpack buffer, the driver hands out fresh memory if the old one is still in use
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, heightUnpackBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    float* dst = static_cast<float*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    for(size_t k = 0; k < frame.grid.size(); ++k)
+        dst[k] = frame.grid[k].height;
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, gridSide+1, gridSide+1, GL_RED, GL_FLOAT, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    uploadedBytes += size;
+
+    VERIFY(CG::checkError());
+}
+
+void
+Spacetime::streamFrame(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::streamFrame");
+
+    unsigned int region = (streamRegion + 1) % streamRegions;
+    writeStreamRegion(region, frame.grid.data(), nullptr, frame.grid.size());
+    regionKeyframes[region].reset();
+
+    // point the dynamic attributes to the new region
+    glBindVertexArray(_vertexArrayObject);
+    bindStreamRegions(region, -1);
+    glBindVertexArray(0);
+
+    streamRegion = region;
+
+    VERIFY(CG::checkError());
+}
+
+void
+Spacetime::keyframeFrame(SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::keyframeFrame");
+
+    float frameTime = time;
+    int index = int(std::floor(frameTime/keyframeInterval));
+
+    // keyframes of other settings are dropped, as are the ones the widget has passed
+    std::vector<float> signature = binarySignature();
+    signature.push_back(float(simSide));
+    signature.push_back(binary.getFarFieldTolerance());
+    if(signature != keyframeSignature)
+    {
+        keyframes.clear();
+        keyframeSignature = signature;
+    }
+    keyframes.erase(std::remove_if(keyframes.begin(), keyframes.end(), [index](const std::shared_ptr<const SpacetimeKeyframe>& keyframe)
+    {
+        return keyframe->index < index - 1 || keyframe->index > index + keyframeLookahead;
+    }), keyframes.end());
+
+    // The keyframes up to the next one are needed right away, the rest is
+    // computed ahead of time, so once the ring is full there is one new
+    // keyframe per keyframeInterval, whatever the rate of the frames.
+    int next = keyframes.empty() ? index : std::max(index, keyframes.back()->index + 1);
+    int last = (next <= index + 1) ? index + 1 : index + keyframeLookahead;
+    for(int k = next; k <= last; ++k)
+    {
+        time = k*keyframeInterval;
+        calcPositions(true);
+
+        auto keyframe = std::make_shared<SpacetimeKeyframe>();
+        keyframe->index = k;
+        keyframe->grid.resize(positions.size());
+        for(size_t v = 0; v < positions.size(); ++v)
+        {
+            keyframe->grid[v].normal = vertex_normals[v];
+            keyframe->grid[v].height = positions[v].y;
+            keyframe->grid[v].curvature = vertex_curvature[v];
+        }
+        keyframe->heightRate = vertex_heightRate;
+        keyframes.push_back(keyframe);
+    }
+    time = frameTime;
+
+    frame.keyframes = keyframes;
+}
+
+void
+Spacetime::uploadKeyframes(const SpacetimeFrame& frame)
+{
+    TRACE_SCOPE("Spacetime::uploadKeyframes");
+
+    // the regions of keyframes the producer retired are free again
+    for(auto & uploaded : regionKeyframes)
+    {
+        if(uploaded && std::find(frame.keyframes.begin(), frame.keyframes.end(), uploaded) == frame.keyframes.end())
+            uploaded.reset();
+    }
+
+    // every keyframe has a fixed region, the live keyframes are consecutive and at most streamRegions
+    for(const auto & keyframe : frame.keyframes)
+    {
+        unsigned int region = ((keyframe->index % int(streamRegions)) + streamRegions) % streamRegions;
+        if(regionKeyframes[region] == keyframe)
+            continue;
+
+        writeStreamRegion(region, keyframe->grid.data(), keyframe->heightRate.data(), keyframe->grid.size());
+        regionKeyframes[region] = keyframe;
+    }
+
+    VERIFY(CG::checkError());
+}
+
+void
+Spacetime::writeStreamRegion(unsigned int region, const StreamVertex* vertices, const float* heightRates, size_t count)
+{
+    GLintptr offset = region*streamRegionSize;
+
+    // wait until the GPU has finished reading this region
+    if(streamFences[region])
+    {
+        while(glClientWaitSync(streamFences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(streamFences[region]);
+        streamFences[region] = 0;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+
+    char* dst;
+    if(streamMapping)
+        dst = static_cast<char*>(streamMapping) + offset;
+    else
+        dst = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, offset, streamRegionSize,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+    // the vertices, then their height rates
+    std::copy(vertices, vertices + count, reinterpret_cast<StreamVertex*>(dst));
+    uploadedBytes += count*sizeof(StreamVertex);
+    if(heightRates)
+    {
+        std::copy(heightRates, heightRates + count, reinterpret_cast<float*>(dst + count*sizeof(StreamVertex)));
+        uploadedBytes += count*sizeof(float);
+    }
+
+    if(!streamMapping)
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+void
+Spacetime::bindStreamRegions(int first, int second) const
+{
+    // normals, heights, curvature and height rates of the first and of the second keyframe
+    static const GLuint locations[2][4] = {{1, 3, 4, 5}, {6, 7, 8, 9}};
+
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    GLintptr rates = texCoords.size()*sizeof(StreamVertex);
+
+    for(int slot = 0; slot < 2; ++slot)
+    {
+        const GLuint* location = locations[slot];
+        int region = slot == 0 ? first : second;
+        if(region < 0)
+        {
+            for(int attribute = 0; attribute < 4; ++attribute)
+                glDisableVertexAttribArray(location[attribute]);
+            continue;
+        }
+
+        GLintptr offset = region*streamRegionSize;
+        glVertexAttribPointer(location[0], 3, GL_FLOAT, GL_TRUE, sizeof(StreamVertex), (void*)(offset + offsetof(StreamVertex, normal)));
+        glVertexAttribPointer(location[1], 1, GL_FLOAT, GL_FALSE, sizeof(StreamVertex), (void*)(offset + offsetof(StreamVertex, height)));
+        glVertexAttribPointer(location[2], 1, GL_FLOAT, GL_FALSE, sizeof(StreamVertex), (void*)(offset + offsetof(StreamVertex, curvature)));
+        glVertexAttribPointer(location[3], 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(offset + rates));
+        for(int attribute = 0; attribute < 3; ++attribute)
+            glEnableVertexAttribArray(location[attribute]);
+
+        // a streamed frame has no height rates, they are only read while blending
+        if(second >= 0)
+            glEnableVertexAttribArray(location[3]);
+        else
+            glDisableVertexAttribArray(location[3]);
+    }
+}
+
+float
+Spacetime::keyframeBlend(int regions[2]) const
+{
+    // the sheet is shown at the time of the frame plus the time the widget advanced since it arrived
+    float position = (shownTime + shownAge)/keyframeInterval;
+    int index = int(std::floor(position));
+
+    auto regionOf = [this](int k)
+    {
+        for(unsigned int region = 0; region < streamRegions; ++region)
+            if(regionKeyframes[region] && regionKeyframes[region]->index == k)
+                return int(region);
+        return -1;
+    };
+
+    regions[0] = regionOf(index);
+    regions[1] = regionOf(index + 1);
+    if(regions[0] >= 0 && regions[1] >= 0)
+        return position - index;
+
+    // a keyframe is missing, e.g. while the widget lags behind: hold the closest one
+    float closest = 0.f;
+    regions[0] = -1;
+    for(unsigned int region = 0; region < streamRegions; ++region)
+    {
+        if(!regionKeyframes[region])
+            continue;
+        float distance = std::abs(regionKeyframes[region]->index - position);
+        if(regions[0] < 0 || distance < closest)
+        {
+            closest = distance;
+            regions[0] = region;
+        }
+    }
+    regions[1] = regions[0];
+    return 0.f;
+}
+
 GLuint
 Spacetime::loadTexture()
 {
@@ -215,180 +1049,165 @@ Spacetime::loadFBO()
 }
 
 void
-Spacetime::calcPositions()
+Spacetime::calcGrid()
 {
-    float xpos, ypos, zpos;
-    float xtex, ytex;
+    auto index = [this](int i, int j) { return i + j*(gridSide + 1); };
+
+    indices.clear();
+    texCoords.clear();
 
-    for(int j = 0; j < nside+1; ++j)
+    for(int j = 0; j < gridSide+1; ++j)
     {
-        zpos = -1 + 2*float(j)/float(nside);
-        ytex = float(j)/float(nside);
+        float ytex = float(j)/float(gridSide);
 
-        for(int i = 0; i < nside+1; ++i)
+        for(int i = 0; i < gridSide+1; ++i)
         {
-            xpos = -1 + 2*float(i)/float(nside);
-            xtex = float(i)/float(nside);
-
-            ypos = potential(xpos, zpos);
-//            ypos = 0.1*sin(xpos/0.1 + (2*3.14/3)*time); // testfunction (plane wave)
+            float xtex = float(i)/float(gridSide);
 
-            positions.push_back(glm::vec3(xpos, ypos, zpos));
             texCoords.push_back(glm::vec2(xtex, ytex));
 
-            if(j < nside && i < nside) // define triangles on grid
+            if(j < gridSide && i < gridSide) // define triangles on grid
             {
-                indices.push_back(nindex(i  ,j  ));
-                indices.push_back(nindex(i  ,j+1));
-                indices.push_back(nindex(i+1,j  ));
+                indices.push_back(index(i  ,j  ));
+                indices.push_back(index(i  ,j+1));
+                indices.push_back(index(i+1,j  ));
 
-                indices.push_back(nindex(i+1,j  ));
-                indices.push_back(nindex(i  ,j+1));
-                indices.push_back(nindex(i+1,j+1));
+                indices.push_back(index(i+1,j  ));
+                indices.push_back(index(i  ,j+1));
+                indices.push_back(index(i+1,j+1));
             }
         }
     }
-    for(auto & pos : positions) pos *= scalefactor;
-
-    // calculation of normals
-    glm::vec3 a_vec, b_vec, c_vec, current_pos;
-    for(int j = 0; j < nside+1; ++j)
-    {
-        for(int i = 0; i < nside+1; ++i)
-        {
-            current_pos = positions[nindex(i, j)];
+}
 
-            if(j < nside && i < nside)
-            {
-                a_vec = positions[nindex(i+1, j)] - current_pos;
-                b_vec = positions[nindex(i, j+1)] - current_pos;
-            }
+void
+Spacetime::calcPositions(bool withNormals)
+{
+    TRACE_SCOPE("Spacetime::calcPositions");
 
-            if(j == nside && i < nside)
-            {
-                a_vec = positions[nindex(i, j-1)] - current_pos;
-                b_vec = positions[nindex(i+1, j)] - current_pos;
-            }
+    int rows = simSide + 1;
 
-            if(j < nside && i == nside)
-            {
-                a_vec = positions[nindex(i, j+1)] - current_pos;
-                b_vec = positions[nindex(i-1, j)] - current_pos;
-            }
+    // with equal masses only the rows up to the middle are solved, each of them also fills its mirror row
+    bool mirror = binary.isPointSymmetric();
+    int solvedRows = mirror ? (rows + 1)/2 : rows;
 
-            if(j == nside && i == nside)
-            {
-                a_vec = positions[nindex(i-1, j)] - current_pos;
-                b_vec = positions[nindex(i, j-1)] - current_pos;
-            }
+    // blocks of a few rows, enough of them for the workers to balance the load
+    int grain = std::max(1, solvedRows/int(4*pool->size()));
 
-            c_vec = glm::cross(b_vec, a_vec);
-            vertex_normals.push_back(glm::normalize(c_vec));
-        }
+    if(positions.size() != size_t(rows*rows))
+    {
+        positions.resize(rows*rows);
+        vertex_normals.resize(rows*rows);
+        vertex_curvature.resize(rows*rows);
+        vertex_heightRate.resize(rows*rows);
+
+        // no initial guesses for the new grid
+        for(auto & cache : retardedTimes)
+            cache.assign(rows*rows, -1.f);
     }
-}
 
-int
-Spacetime::nindex(int i, int j)
-{
-    return i + j*(nside + 1);
+    // normals and curvature come with the heights, from the derivatives of the potential
+    pool->parallelFor(0, solvedRows, grain, [this, mirror, withNormals](int first, int last)
+    {
+        calcHeightRows(first, last, mirror, withNormals);
+    });
 }
 
-glm::vec2
-Spacetime::trajectory(float utime, int objectnr)
+void
+Spacetime::calcHeightRows(int jfirst, int jlast, bool mirror, bool withNormals)
 {
-    glm::vec2 position = glm::vec2(sin(omega*utime + objectnr*2*M_PI_2), cos(omega*utime + objectnr*2*M_PI_2));
+    TRACE_SCOPE("Spacetime::calcHeightRows");
 
-    if(objectnr == 0)
-        position *= separation*(pow(R_N1, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
-    else if(objectnr == 1)
-        position *= separation*(pow(R_N0, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
+    float zpos;
+    RetardedStats stats;
 
-    return position;
-}
+    std::vector<float> xpos(simSide+1);
+    std::vector<float> ypos(simSide+1);
+    std::vector<float> zrow(simSide+1);
+    std::vector<Dual<true>> derivatives(withNormals ? simSide+1 : 0);
+    float omega = binary.parameters().omega;
+    for(int i = 0; i < simSide+1; ++i)
+        xpos[i] = -1 + 2*float(i)/float(simSide);
 
-float
-Spacetime::helperfunction(float delta_t, glm::vec2& rpos, int objectnr) // function that satisfies the retardation condition when equal to zero (depends on trajectory)
-{
-    float rho_N;
-    if(objectnr == 0)
-        rho_N = separation*(pow(R_N1, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
-    else if(objectnr == 1)
-        rho_N = separation*(pow(R_N0, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
+    for(int j = jfirst; j < jlast; ++j)
+    {
+        zpos = -1 + 2*float(j)/float(simSide);
+        std::fill(zrow.begin(), zrow.end(), zpos);
 
-    float phi = omega*(time - delta_t) + objectnr*2*M_PI_2;
+        // one batch per row, warm started from the retarded times of the last frame
+        float* delta_t0 = &retardedTimes[0][nindex(0, j)];
+        float* delta_t1 = &retardedTimes[1][nindex(0, j)];
+        binary.potentialBatch(time, xpos.data(), zrow.data(), ypos.data(), simSide+1, delta_t0, delta_t1, &stats);
+//            ypos = 0.1*sin(xpos/0.1 + (2*3.14/3)*time); // testfunction (plane wave)
 
-    return c_light_fraction*sqrt(pow(rpos.x,2) + pow(rpos.y,2) + rho_N*rho_N - 2*rho_N*(rpos.x*sin(phi) + rpos.y*cos(phi))) - rho_N*omega*delta_t;
-}
+        for(int i = 0; i < simSide+1; ++i)
+            positions[nindex(i, j)] = scalefactor*glm::vec3(xpos[i], ypos[i], zpos);
 
-float
-Spacetime::ddt_helpfunc(float delta_t, glm::vec2& rpos, int objectnr) // derivative (d/d(delta_t) of helperfunction
-{
-    float rho_N;
-    if(objectnr == 0)
-        rho_N = separation*(pow(R_N1, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
-    else if(objectnr == 1)
-        rho_N = separation*(pow(R_N0, 3)/(pow(R_N0, 3) + pow(R_N1, 3)));
+        if(withNormals)
+        {
+            binary.potentialDerivatives(time, xpos.data(), zrow.data(), delta_t0, delta_t1, derivatives.data(), simSide+1);
 
-    float phi = omega*(time - delta_t) + objectnr*2*M_PI_2;
-    float result = c_light_fraction*rho_N*omega*(rpos.x*cos(phi) - rpos.y*sin(phi));
-    result /= sqrt(rpos.x*rpos.x +  rpos.y*rpos.y + rho_N*rho_N - 2*rho_N*(rpos.x*sin(phi) + rpos.y*cos(phi)));
-    result -= rho_N*omega;
+            // the sheet is scalefactor*(x, potential(x, z), z), its slopes do not depend on the scale
+            for(int i = 0; i < simSide+1; ++i)
+            {
+                glm::vec2 g = derivatives[i].gradient;
+                glm::vec3 h = derivatives[i].hessian;
+                float w2 = 1.f + glm::dot(g, g);
 
-    return result;
-}
+                vertex_normals[nindex(i, j)] = glm::normalize(glm::vec3(-g.x, 1.f, -g.y));
+                vertex_curvature[nindex(i, j)] = ((1.f + g.y*g.y)*h.x - 2.f*g.x*g.y*h.y + (1.f + g.x*g.x)*h.z)
+                        /(2.f*w2*std::sqrt(w2)*scalefactor);
 
-float
-Spacetime::retardedDistance(glm::vec2& rpos, glm::vec2& r0, int objectnr, int iterations)
-{
-    float delta_t_start = glm::length(rpos - r0)/c_light;
-    float delta_t = delta_t_start;
-
-    float a, b;
+                // the field of the circular binary rotates rigidly with omega, so its time derivative
+                // is the derivative along the circle through the vertex (see updateCorotatingField())
+                vertex_heightRate[nindex(i, j)] = scalefactor*omega*(xpos[i]*g.y - zpos*g.x);
+            }
+        }
 
-    int n = 0;
-    do
-    {
-        delta_t = delta_t_start - n*.1;
-        for(int i = 0; i < iterations; ++i)
+        // the vertex (i, j) mirrors to (simSide - i, simSide - j), see Binary::isPointSymmetric(),
+        // the gradient changes sign there while the Hessian stays the same
+        if(mirror && j != simSide - j)
         {
-            a = ddt_helpfunc(delta_t, rpos, objectnr);
-            b = helperfunction(delta_t, rpos, objectnr) - a*delta_t;
-            delta_t = -1*b/a;
+            float zmirror = -1 + 2*float(simSide - j)/float(simSide);
+            for(int i = 0; i < simSide+1; ++i)
+            {
+                int k = nindex(simSide - i, simSide - j);
+                positions[k] = scalefactor*glm::vec3(xpos[simSide - i], ypos[i], zmirror);
+                if(withNormals)
+                {
+                    glm::vec3 n = vertex_normals[nindex(i, j)];
+                    vertex_normals[k] = glm::vec3(-n.x, n.y, -n.z);
+                    vertex_curvature[k] = vertex_curvature[nindex(i, j)];
+                    vertex_heightRate[k] = vertex_heightRate[nindex(i, j)];
+                }
+            }
         }
-        ++n;
     }
-    while(abs(helperfunction(delta_t, rpos, objectnr)) > 0.01);
 
-    glm::vec2 r0_ret = glm::vec2(trajectory(time - delta_t, objectnr));
-    return glm::length(rpos - r0_ret);
+    std::lock_guard<std::mutex> lock(statsMutex);
+    newtonStats += stats;
 }
 
-float
-Spacetime::potential(float xpos, float zpos)
+RetardedStats
+Spacetime::getNewtonStats() const
 {
-    glm::vec2 rpos = glm::vec2(xpos, zpos);
-
-    glm::vec2 r0 = trajectory(time, 0);
-    glm::vec2 r1 = trajectory(time, 1);
-
-    float dist0_ret = retardedDistance(rpos, r0, 0, 5);
-    float dist1_ret = retardedDistance(rpos, r1, 1, 5);
-
-    float potential0;
-    float potential1;
-
-    if(dist0_ret < R_N0)
-        potential0  = 0.5*GM0*std::pow(dist0_ret, 2)/pow(R_N0, 3) - 1.5*GM0/R_N0;
-    else
-        potential0  = -1*GM0/dist0_ret;
+    return shownStats;
+}
 
-    if(dist1_ret < R_N1)
-        potential1  = 0.5*GM1*std::pow(dist1_ret, 2)/pow(R_N1, 3) - 1.5*GM1/R_N1;
-    else
-        potential1  = -1*GM1/dist1_ret;
+int
+Spacetime::nindex(int i, int j)
+{
+    return i + j*(simSide + 1);
+}
 
-    float potential = potential0 + potential1;
+void
+Spacetime::setFarFieldTolerance(float tolerance)
+{
+    farFieldTolerance = tolerance;
+}
 
-    return potential;//*5*sqrt(xpos*xpos + zpos*zpos);
+float
+Spacetime::getFarFieldTolerance() const
+{
+    return farFieldTolerance;
 }
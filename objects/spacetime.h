@@ -3,14 +3,96 @@
 
 #include "objects/drawable.h"
 #include "image/image.h"
+#include "util/threadpool.h"
+#include "physics/binary.h"
+#include "objects/quadtree.h"
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <stack>
+#include <mutex>
 #include <glm/vec3.hpp>
 
+/**
+ * @brief The eRenderPath enum lists the ways the spacetime sheet can be generated
+ */
+enum eRenderPath
+{
+    ePathStreamed,      /**< heights and normals from the CPU, streamed every frame */
+    ePathCorotating,    /**< rotated lookups into a precomputed co-rotating field */
+    ePathHeightTexture, /**< heights from the CPU as texture, displaced in the vertex shader */
+    ePathTessellated,   /**< coarse patches, refined and displaced on the GPU */
+    ePathQuadtree,      /**< adaptive quadtree mesh from the CPU */
+    ePathKeyframed,     /**< full grid frames from the CPU at a low rate, interpolated on the GPU */
+    eRenderPathCount
+};
+
+/**
+ * @brief renderPathName Getter for a readable name of a render path
+ * @param path the render path
+ * @return the name
+ */
+const char* renderPathName(eRenderPath path);
+
+/**
+ * @brief The StreamVertex struct is the per frame vertex data of the grid
+ *
+ * Only this part of a vertex changes between frames and is
+ * streamed into the ring buffer.
+ */
+struct StreamVertex
+{
+    glm::vec3 normal;
+    float height;
+    float curvature;    /**< mean curvature of the sheet, 0 where it is not computed */
+};
+
+/**
+ * @brief The SpacetimeKeyframe struct is one grid frame of the keyframed path
+ *
+ * Keyframes are shared by the producer and every frame that carries them,
+ * like the co-rotating field, so a frame the widget skips loses nothing.
+ */
+struct SpacetimeKeyframe
+{
+    int index = 0;                  /**< the keyframe is at the time index*Spacetime::keyframeInterval */
+    std::vector<StreamVertex> grid; /**< normals, heights and curvature */
+    std::vector<float> heightRate;  /**< time derivative of the heights */
+};
+
+/**
+ * @brief The SpacetimeFrame struct is everything the CPU computes for one frame of the sheet
+ *
+ * Frames are produced by Spacetime::produceFrame() without touching
+ * OpenGL, possibly on another thread, and handed to
+ * Spacetime::uploadFrame() on the thread that owns the context.
+ * Only the data of the frame's render path is filled in.
+ */
+struct SpacetimeFrame
+{
+    float time = 0.f;                       /**< simulation time of the frame */
+    eRenderPath path = ePathStreamed;       /**< render path the data was produced for */
+    int side = 0;                           /**< nside of the grid data */
+    glm::vec2 bodies[2];                    /**< positions of both bodies */
+    BinaryParameters parameters;            /**< the binary the frame was produced for */
+    int solverIterations = 0;               /**< its retarded time solver settings, for the tessellated path */
+    float solverTolerance = 0.f;
+
+    std::vector<StreamVertex> grid;         /**< streamed and height texture path: normals, heights and curvature */
+    std::vector<SheetVertex> meshVertices;  /**< quadtree path: the adaptive mesh */
+    std::vector<unsigned int> meshIndices;
+    std::shared_ptr<const std::vector<float>> field; /**< co-rotating path: the field it rotates */
+    std::vector<std::shared_ptr<const SpacetimeKeyframe>> keyframes; /**< keyframed path: the keyframes around the time of the frame, oldest first */
+
+    RetardedStats stats;                    /**< solver work of this frame */
+    double cpuMs = 0.;                      /**< time it took to produce the frame */
+};
+
 class Spacetime : public Drawable
 {
 public:
+    static constexpr float keyframeInterval = 1.f/15.f;    /**< simulation time between two keyframes of the keyframed path */
+
     Spacetime(std::string name = "SPACETIME", std::string textureLocation = ":/res/images/gridlines.png");
 
     /**
@@ -28,6 +110,126 @@ public:
      */
     virtual void update(float elapsedTimeMs, glm::mat4 modelViewMatrix) override;
 
+    /**
+     * @brief recreate Produces and uploads a frame for the time advanced by update()
+     *
+     * This is the synchronous path, see produceFrame() and uploadFrame()
+     * for producing frames on another thread.
+     */
+    virtual void recreate() override;
+
+    /**
+     * @brief produceFrame computes the sheet of the requested render path at a given time
+     * @param frame receives the data, its buffers are reused
+     * @param frameTime the simulation time
+     *
+     * No OpenGL calls are made, so this may run on a simulation thread
+     * while the widget renders. Only one thread may produce at a time.
+     */
+    void produceFrame(SpacetimeFrame& frame, float frameTime);
+
+    /**
+     * @brief uploadFrame makes a frame the one that is drawn
+     * @param frame a frame from produceFrame()
+     *
+     * The static parts of the grid (xz positions, texture coordinates
+     * and indices) are only rebuilt if the grid resolution changed.
+     * Otherwise only the heights and normals are written into the
+     * next region of the stream ring, or for the keyframed path the
+     * keyframes that are not on the GPU yet.
+     */
+    void uploadFrame(const SpacetimeFrame& frame);
+
+    /**
+     * @brief getNewtonStats Getter for the retarded time solver statistics
+     * @return the work of both bodies for the frame that is drawn
+     */
+    RetardedStats getNewtonStats() const;
+
+    /**
+     * @brief getFrameCpuMs Getter for the time it took to produce the frame that is drawn
+     */
+    double getFrameCpuMs() const;
+
+    /**
+     * @brief getUploadedBytes Getter for the amount of data the last uploadFrame() sent to the GPU
+     */
+    size_t getUploadedBytes() const;
+
+    /**
+     * @brief getNside Getter for the requested grid resolution
+     */
+    int getNside() const;
+
+    /**
+     * @brief setNside sets the grid resolution of the following frames
+     * @param side number of grid cells along each side
+     *
+     * The streamed, height texture and co-rotating paths use the grid,
+     * its static buffers are rebuilt when the first frame of the new
+     * resolution is uploaded.
+     */
+    void setNside(int side);
+
+    /**
+     * @brief setFarFieldTolerance sets the allowed error of the far-field expansion
+     * @param tolerance allowed error of the potential, 0 solves the retardation condition everywhere
+     *
+     * Vertices far enough from the binary that the expansion is within
+     * the tolerance skip the Newton solver (see RetardedFarField).
+     */
+    void setFarFieldTolerance(float tolerance);
+
+    /**
+     * @brief getFarFieldTolerance Getter for the allowed error of the far-field expansion
+     */
+    float getFarFieldTolerance() const;
+
+    /**
+     * @brief setPotentialModel selects the potential profile of the bodies from the next frame on
+     * @param model the profile, see potentialmodel.h
+     */
+    void setPotentialModel(ePotentialModel model);
+
+    /**
+     * @brief getPotentialModel Getter for the requested potential profile
+     */
+    ePotentialModel getPotentialModel() const;
+
+    /**
+     * @brief setCurvatureColouring tints the sheet by its mean curvature, where the path provides it
+     *
+     * The streamed path computes the curvature from the exact Hessian of
+     * the potential, the other paths draw untinted.
+     */
+    void setCurvatureColouring(bool enabled);
+
+    /**
+     * @brief getCurvatureColouring Getter for whether the sheet is tinted by its curvature
+     */
+    bool getCurvatureColouring() const;
+
+    /**
+     * @brief setRenderPath selects how the sheet is generated
+     * @param path the requested render path
+     *
+     * The co-rotating path is only used while the binary is stationary,
+     * otherwise the streamed path is used instead (see getActivePath()).
+     */
+    void setRenderPath(eRenderPath path);
+
+    /**
+     * @brief getRenderPath Getter for the requested render path
+     * @return the path set by setRenderPath()
+     */
+    eRenderPath getRenderPath() const;
+
+    /**
+     * @brief getActivePath Getter for the render path of the current frame
+     * @return the path actually used for drawing
+     */
+    eRenderPath getActivePath() const;
+
 protected:
 
 
@@ -57,36 +259,118 @@ protected:
 
     void loadFBO();
 
-    void calcPositions();
+    void buildGrid(int side);
+    void calcGrid();
+    void calcPositions(bool withNormals = true);
+    void streamFrame(const SpacetimeFrame& frame);
+    void keyframeFrame(SpacetimeFrame& frame);
+    void uploadKeyframes(const SpacetimeFrame& frame);
+    void writeStreamRegion(unsigned int region, const StreamVertex* vertices, const float* heightRates, size_t count);
+    void bindStreamRegions(int first, int second) const;
+    float keyframeBlend(int regions[2]) const;
+    void heightFrame(const SpacetimeFrame& frame);
+    void quadtreeFrame(SpacetimeFrame& frame);
+    void uploadQuadtree(const SpacetimeFrame& frame);
+    void uploadField(const SpacetimeFrame& frame);
     int nindex(int, int);
 
-    glm::vec2 trajectory(float, int);
-    float helperfunction(float, glm::vec2&, int);
-    float ddt_helpfunc(float delta_t, glm::vec2&, int objectnr);
-    float retardedDistance(glm::vec2&, glm::vec2&, int, int);
-    float potential(float, float);
+    void setLightingUniforms(GLuint program) const;
+    GLuint createProgram(std::string vertexShaderPath,
+                         std::string tessControlShaderPath = "", std::string tessEvaluationShaderPath = "") const;
+    void setBinaryUniforms(GLuint program) const;
+    GLuint pathProgram(eRenderPath path) const;
 
     std::vector<glm::vec3> positions;
     std::vector<unsigned int> indices;
     std::vector<glm::vec3> vertex_normals;
+    std::vector<float> vertex_curvature;
+    std::vector<float> vertex_heightRate;
     std::vector<glm::vec2> texCoords;
 
-    int nside;
+    static const int keyframeLookahead = 2;      /**< keyframes computed ahead of the one that is shown */
+    static const unsigned int streamRegions = keyframeLookahead + 2; /**< number of regions in the stream ring, also one per live keyframe */
+
+    GLuint gridBuffer;              /**< static xz positions and texture coordinates */
+    GLuint indexBuffer;             /**< static triangle indices */
+    GLuint streamBuffer;            /**< ring of streamRegions regions of StreamVertex, each followed by the height rates */
+    void* streamMapping;            /**< persistent mapping of streamBuffer (nullptr if unsupported) */
+    GLsizeiptr streamRegionSize;    /**< size of one ring region in bytes */
+    unsigned int streamRegion;      /**< region that holds the current frame */
+    mutable GLsync streamFences[streamRegions]; /**< signalled when the GPU is done with a region */
+    std::shared_ptr<const SpacetimeKeyframe> regionKeyframes[streamRegions]; /**< keyframe held by each region, if any */
+    int gridSide;                   /**< nside the static buffers were built for */
+
+    // Everything up to the co-rotating field is used by produceFrame(), the
+    // GL objects below only by the thread of the context. Settings that the
+    // widget changes while a simulation thread produces are atomic.
+    std::unique_ptr<ThreadPool> pool; /**< evaluates the grid rows in parallel */
+    int simSide;                    /**< nside of the frame being produced */
+
+    std::vector<float> retardedTimes[2]; /**< per vertex delta_t of both bodies, initial guess for the next frame */
+    RetardedStats newtonStats;           /**< solver work of the last grid evaluation */
+    std::mutex statsMutex;
+
+    Binary binary;                  /**< the physics, evaluated at the time of the frame being produced */
+    std::atomic<float> farFieldTolerance; /**< allowed error of the potential, applied to binary per frame */
+    std::atomic<ePotentialModel> potentialModel; /**< potential profile, applied to binary per frame */
+
+    std::atomic<eRenderPath> renderPath; /**< requested render path */
+
+    std::vector<std::shared_ptr<const SpacetimeKeyframe>> keyframes; /**< live keyframes of the keyframed path, oldest first */
+    std::vector<float> keyframeSignature; /**< settings the keyframes were computed with */
+    bool curvatureColouring;
+
+    // the frame that is drawn
+    Binary shownBinary;         /**< copy of the binary of the current frame, read by draw() */
+    eRenderPath activePath;     /**< render path of the current frame */
+    float shownTime;            /**< simulation time of the current frame */
+    float shownAge;             /**< time update() advanced since the current frame was uploaded */
+    RetardedStats shownStats;
+    double shownCpuMs;
+    size_t uploadedBytes;       /**< bytes sent to the GPU by the last uploadFrame() */
+    bool hasFrame;              /**< false until the first frame was uploaded */
+    SpacetimeFrame syncFrame;   /**< frame of recreate() */
+
+    // co-rotating field: the potential at time 0 in polar coordinates (angle, radius)
+    GLuint corotProgram;
+    GLuint fieldTexture;
+    int fieldAngles;            /**< texture width, samples in the angle */
+    int fieldRadii;             /**< texture height, samples in the radius */
+    float fieldRadius;          /**< radius covered by the field */
+    std::vector<float> fieldSignature;  /**< physical parameters the field was computed for */
+    std::vector<float> lastSignature;   /**< physical parameters of the last frame */
+    std::shared_ptr<const std::vector<float>> field;            /**< produced field */
+    std::shared_ptr<const std::vector<float>> uploadedField;    /**< field in fieldTexture */
+
+    // height texture: the potential of every vertex, uploaded through a pixel unpack buffer
+    GLuint heightProgram;
+    GLuint heightTexture;
+    GLuint heightUnpackBuffer;
+
+    // tessellation: coarse patches refined by screen space size and distance to the stars
+    GLuint tessProgram;
+    GLuint patchVertexArray;
+    GLuint patchBuffer;
+    int patchSide;              /**< number of patches along each side */
+
+    // quadtree: restricted quadtree refined by the interpolation error of the potential
+    std::unique_ptr<Quadtree> quadtree;
+    float quadtreeTolerance;    /**< allowed interpolation error of the potential */
+    GLuint quadtreeVertexArray;
+    GLuint quadtreeVertexBuffer;
+    GLuint quadtreeIndexBuffer;
+    GLsizei quadtreeIndexCount;
+
+    std::vector<float> binarySignature() const;
+    bool updateCorotatingField();
+    void calcCorotatingField();
+
+    void calcHeightRows(int, int, bool, bool);
+
+    std::atomic<int> nside;     /**< requested grid resolution */
     float scalefactor;
-    float time;
-
-    // physical parameters
-    float
-    c_light,
-    c_light_fraction,
-    omega,
-    R_N0,
-    R_N1,
-    gravConst,
-    density,
-    separation,
-    GM0,
-    GM1;
+    float time;                 /**< simulation time of the frame being produced */
+    float clockTime;            /**< time advanced by update(), used by recreate() */
 };
 
 #endif // SPACETIME_H
@@ -0,0 +1,167 @@
+#include <GL/glew.h>
+
+#include "upscaler.h"
+
+#include <algorithm>
+
+#include "glbase/gltool.hpp"
+#include "glbase/texload.hpp"
+#include "util/trace.h"
+
+Upscaler::Upscaler(std::string name) : Drawable(name),
+    depthBuffer(0), windowWidth(1), windowHeight(1), targetWidth(0), targetHeight(0),
+    scale(100), direct(true)
+{
+    _frameBufferObject = 0;
+}
+
+void
+Upscaler::draw(glm::mat4 projection_matrix) const
+{
+    TRACE_SCOPE("Upscaler::draw");
+
+    glUseProgram(_program);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glUniform1i(glGetUniformLocation(_program, "scene"), 0);
+
+    // no sharpening without upscaling, full strength from a factor of two
+    float factor = float(windowWidth)/float(targetWidth);
+    glUniform1f(glGetUniformLocation(_program, "sharpness"), std::min(1.f, factor - 1.f));
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    // one triangle covering the viewport, the vertices are generated from gl_VertexID
+    glBindVertexArray(_vertexArrayObject);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    if(depthTest)
+        glEnable(GL_DEPTH_TEST);
+    if(blend)
+        glEnable(GL_BLEND);
+
+    VERIFY(CG::checkError());
+}
+
+void
+Upscaler::update(float elapsedTimeMs, glm::mat4 modelViewMatrix)
+{
+}
+
+void
+Upscaler::resize(int width, int height)
+{
+    windowWidth = std::max(1, width);
+    windowHeight = std::max(1, height);
+}
+
+void
+Upscaler::setScale(int percent)
+{
+    scale = std::max(1, std::min(100, percent));
+}
+
+int
+Upscaler::getScale() const
+{
+    return scale;
+}
+
+void
+Upscaler::begin(bool native)
+{
+    direct = (scale == 100 && !native);
+    if(direct)
+        return;
+
+    int width = native ? windowWidth : std::max(1, windowWidth*scale/100);
+    int height = native ? windowHeight : std::max(1, windowHeight*scale/100);
+    allocate(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferObject);
+    glViewport(0, 0, targetWidth, targetHeight);
+}
+
+void
+Upscaler::end(GLuint framebuffer)
+{
+    if(direct)
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, windowWidth, windowHeight);
+
+    draw(glm::mat4(1.f));
+}
+
+bool
+Upscaler::save(const std::string& filename) const
+{
+    if(direct)
+        return false;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    return save_png(GL_TEXTURE_2D, filename);
+}
+
+std::string
+Upscaler::getVertexShader() const
+{
+    return Drawable::loadShaderFile(":/shader/upscale.vs.glsl");
+}
+
+std::string
+Upscaler::getFragmentShader() const
+{
+    return Drawable::loadShaderFile(":/shader/upscale.fs.glsl");
+}
+
+void
+Upscaler::createObject()
+{
+    // the core profile needs a vertex array object even without attributes
+    glGenVertexArrays(1, &_vertexArrayObject);
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glGenFramebuffers(1, &_frameBufferObject);
+
+    VERIFY(CG::checkError());
+}
+
+void
+Upscaler::allocate(int width, int height)
+{
+    if(width == targetWidth && height == targetHeight)
+        return;
+
+    TRACE_SCOPE("Upscaler::allocate");
+
+    targetWidth = width;
+    targetHeight = height;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferObject);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    VERIFY(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    VERIFY(CG::checkError());
+}
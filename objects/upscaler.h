@@ -0,0 +1,100 @@
+#ifndef UPSCALER_H
+#define UPSCALER_H
+
+#include "objects/drawable.h"
+
+#include <string>
+
+/**
+ * @brief The Upscaler class renders the scene at a reduced resolution and scales it up
+ *
+ * Between begin() and end() the scene is drawn into an offscreen
+ * framebuffer of scale percent of the window size. end() draws it over the
+ * window with bilinear filtering and a sharpening filter whose strength
+ * grows with the upscaling factor. At 100 percent the scene is drawn
+ * into the window directly and nothing is copied.
+ */
+class Upscaler : public Drawable
+{
+public:
+    Upscaler(std::string name = "UPSCALER");
+
+    /**
+     * @see Drawable::draw(glm::mat4), draws the offscreen scene over the bound framebuffer
+     */
+    virtual void draw(glm::mat4 projection_matrix) const override;
+
+    /**
+     * @see Drawable::update(float, glm::mat4), nothing to do
+     */
+    virtual void update(float elapsedTimeMs, glm::mat4 modelViewMatrix) override;
+
+    /**
+     * @brief resize sets the size of the window in pixels
+     */
+    void resize(int width, int height);
+
+    /**
+     * @brief setScale sets the render resolution of the following frames
+     * @param percent the size of the offscreen framebuffer relative to the window
+     */
+    void setScale(int percent);
+
+    /**
+     * @brief getScale Getter for the render resolution in percent of the window
+     */
+    int getScale() const;
+
+    /**
+     * @brief begin redirects the scene into the offscreen framebuffer
+     * @param native render at the size of the window regardless of the scale, e.g. for a screenshot
+     *
+     * The viewport is set to the size of the framebuffer.
+     */
+    void begin(bool native = false);
+
+    /**
+     * @brief end scales the scene up into a framebuffer of the window size
+     * @param framebuffer the framebuffer of the window
+     */
+    void end(GLuint framebuffer);
+
+    /**
+     * @brief save writes the scene of the last begin() as PNG, call before end()
+     * @param filename the file to write
+     * @return false if the file could not be written
+     */
+    bool save(const std::string& filename) const;
+
+protected:
+
+    /**
+     * @see Drawable::getVertexShader()
+     */
+    virtual std::string getVertexShader() const override;
+
+    /**
+     * @see Drawable::getFragmentShader()
+     */
+    virtual std::string getFragmentShader() const override;
+
+    /**
+     * @see Drawable::createObject()
+     */
+    virtual void createObject() override;
+
+    /**
+     * @brief allocate sizes the offscreen framebuffer, if it does not have the size yet
+     */
+    void allocate(int width, int height);
+
+    GLuint depthBuffer;     /**< depth renderbuffer of _frameBufferObject */
+    int windowWidth;
+    int windowHeight;
+    int targetWidth;        /**< size of the offscreen framebuffer */
+    int targetHeight;
+    int scale;              /**< in percent */
+    bool direct;            /**< the current frame is drawn into the window */
+};
+
+#endif // UPSCALER_H
@@ -0,0 +1,360 @@
+#include "physics/binary.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template<class Profile>
+void sumPotentials(const Profile& profile0, const Profile& profile1, const float* dist0_ret, const float* dist1_ret,
+                   float* potential, int count)
+{
+    for(int i = 0; i < count; ++i)
+        potential[i] = profile0(dist0_ret[i]) + profile1(dist1_ret[i]);
+}
+
+/**
+ * @brief retardedDistanceDual refines a solved delta_t and returns the retarded distance with its derivatives
+ */
+template<bool H>
+Dual<H> retardedDistanceDual(const RetardedOrbit& orbit, const Dual<H>& x, const Dual<H>& z, float delta_t)
+{
+    const float rhoOmega = orbit.rho*orbit.omega;
+    const int steps = H ? 2 : 1;
+
+    Dual<H> dt(delta_t);
+    for(int step = 0; ; ++step)
+    {
+        Dual<H> phi = orbit.phase - orbit.omega*dt;
+        Dual<H> s, c;
+        sincos(phi, s, c);
+        Dual<H> dist = sqrt(x*x + z*z + orbit.rho*orbit.rho - 2.f*orbit.rho*(x*s + z*c));
+        if(step == steps)
+            return dist;
+
+        Dual<H> h = orbit.c_light_fraction*dist - rhoOmega*dt;
+        Dual<H> ddt = orbit.c_light_fraction*rhoOmega*(x*c - z*s)/dist - rhoOmega;
+        dt = dt - h/ddt;
+    }
+}
+
+template<bool H, class Profile>
+void sumDerivatives(const Profile& profile0, const Profile& profile1, const RetardedOrbit* orbit,
+                    const float* xpos, const float* zpos, const float* delta_t0, const float* delta_t1,
+                    Dual<H>* result, int count)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        Dual<H> x = Dual<H>::variable(xpos[i], 0);
+        Dual<H> z = Dual<H>::variable(zpos[i], 1);
+        result[i] = profile0(retardedDistanceDual(orbit[0], x, z, delta_t0[i]))
+                + profile1(retardedDistanceDual(orbit[1], x, z, delta_t1[i]));
+    }
+}
+
+}
+
+Binary::Binary(const BinaryParameters& parameters) :
+    _farFieldTolerance(1e-5f), _farFieldRadius(std::numeric_limits<float>::infinity()),
+    _solverIterations(16), _solverTolerance(1e-6f)
+{
+    setParameters(parameters);
+}
+
+void
+Binary::setParameters(const BinaryParameters& parameters)
+{
+    _parameters = parameters;
+
+    const BinaryParameters& p = _parameters;
+    _GM[0] = p.gravConst*p.density*(4./3.)*2*M_PI_2*std::pow(p.R_N0, 3);
+    _GM[1] = p.gravConst*p.density*(4./3.)*2*M_PI_2*std::pow(p.R_N1, 3);
+    _c_light = p.omega*p.separation/(2*p.c_light_fraction);
+
+    float volume0 = std::pow(p.R_N0, 3), volume1 = std::pow(p.R_N1, 3);
+    _rho[0] = p.separation*volume1/(volume0 + volume1);
+    _rho[1] = p.separation*volume0/(volume0 + volume1);
+
+    updateFarField();
+}
+
+glm::vec2
+Binary::trajectory(float time, int objectnr) const
+{
+    float omega = _parameters.omega;
+    glm::vec2 position = glm::vec2(sin(omega*time + objectnr*2*M_PI_2), cos(omega*time + objectnr*2*M_PI_2));
+
+    return orbitRadius(objectnr)*position;
+}
+
+RetardedOrbit
+Binary::retardedOrbit(float time, int objectnr) const
+{
+    RetardedOrbit orbit;
+    orbit.rho = orbitRadius(objectnr);
+
+    // reduce the phase in double precision, the batch sincos is only accurate for small arguments
+    orbit.phase = std::fmod(double(_parameters.omega)*time + objectnr*2*M_PI_2, 4*M_PI_2);
+    orbit.omega = _parameters.omega;
+    orbit.c_light = _c_light;
+    orbit.c_light_fraction = _parameters.c_light_fraction;
+    orbit.iterations = _solverIterations;
+    orbit.tolerance = _solverTolerance;
+
+    return orbit;
+}
+
+float
+Binary::helperfunction(float time, float delta_t, const glm::vec2& rpos, int objectnr) const // function that satisfies the retardation condition when equal to zero (depends on trajectory)
+{
+    float rho_N = orbitRadius(objectnr);
+    float omega = _parameters.omega;
+
+    float phi = omega*(time - delta_t) + objectnr*2*M_PI_2;
+
+    return _parameters.c_light_fraction*sqrt(pow(rpos.x,2) + pow(rpos.y,2) + rho_N*rho_N - 2*rho_N*(rpos.x*sin(phi) + rpos.y*cos(phi))) - rho_N*omega*delta_t;
+}
+
+float
+Binary::ddt_helpfunc(float time, float delta_t, const glm::vec2& rpos, int objectnr) const // derivative (d/d(delta_t) of helperfunction
+{
+    float rho_N = orbitRadius(objectnr);
+    float omega = _parameters.omega;
+
+    float phi = omega*(time - delta_t) + objectnr*2*M_PI_2;
+    float result = _parameters.c_light_fraction*rho_N*omega*(rpos.x*cos(phi) - rpos.y*sin(phi));
+    result /= sqrt(rpos.x*rpos.x +  rpos.y*rpos.y + rho_N*rho_N - 2*rho_N*(rpos.x*sin(phi) + rpos.y*cos(phi)));
+    result -= rho_N*omega;
+
+    return result;
+}
+
+float
+Binary::retardedDistance(float time, const glm::vec2& rpos, int objectnr) const
+{
+    // the retarded distance lies in [|r - rho|, r + rho], which brackets delta_t
+    float rho_N = orbitRadius(objectnr);
+    float toDeltaT = _parameters.c_light_fraction/(rho_N*_parameters.omega);
+    float r = glm::length(rpos);
+    float lo = std::abs(r - rho_N)*toDeltaT;
+    float hi = (r + rho_N)*toDeltaT;
+
+    float delta_t = glm::length(rpos - trajectory(time, objectnr))*toDeltaT;
+
+    for(int i = 0; i < _solverIterations; ++i)
+    {
+        float h = helperfunction(time, delta_t, rpos, objectnr);
+        if(std::abs(h) <= _solverTolerance)
+            break;
+
+        // helperfunction decreases in delta_t
+        if(h > 0)
+            lo = delta_t;
+        else
+            hi = delta_t;
+
+        float next = delta_t - h/ddt_helpfunc(time, delta_t, rpos, objectnr);
+        delta_t = (next > lo && next < hi) ? next : 0.5f*(lo + hi);
+    }
+
+    glm::vec2 r0_ret = glm::vec2(trajectory(time - delta_t, objectnr));
+    return glm::length(rpos - r0_ret);
+}
+
+float
+Binary::bodyPotential(float dist_ret, int objectnr) const
+{
+    float GM = _GM[objectnr];
+    float R_N = bodyRadius(objectnr);
+
+    switch(_parameters.model)
+    {
+    case eModelSoftened:
+        return SoftenedProfile(GM, R_N)(dist_ret);
+    case eModelYukawa:
+        return YukawaProfile(GM, R_N, _parameters.yukawaLength)(dist_ret);
+    default:
+        return NewtonianProfile(GM, R_N)(dist_ret);
+    }
+}
+
+void
+Binary::bodyPotentials(const float* dist0_ret, const float* dist1_ret, float* potential, int count) const
+{
+    const BinaryParameters& p = _parameters;
+
+    switch(p.model)
+    {
+    case eModelSoftened:
+        sumPotentials(SoftenedProfile(_GM[0], p.R_N0), SoftenedProfile(_GM[1], p.R_N1),
+                      dist0_ret, dist1_ret, potential, count);
+        break;
+    case eModelYukawa:
+        sumPotentials(YukawaProfile(_GM[0], p.R_N0, p.yukawaLength), YukawaProfile(_GM[1], p.R_N1, p.yukawaLength),
+                      dist0_ret, dist1_ret, potential, count);
+        break;
+    default:
+        sumPotentials(NewtonianProfile(_GM[0], p.R_N0), NewtonianProfile(_GM[1], p.R_N1),
+                      dist0_ret, dist1_ret, potential, count);
+    }
+}
+
+float
+Binary::potential(float time, float xpos, float zpos) const
+{
+    if(xpos*xpos + zpos*zpos >= _farFieldRadius*_farFieldRadius)
+    {
+        float dist_ret[2];
+        for(int objectnr = 0; objectnr < 2; ++objectnr)
+            _farField[objectnr].distance(retardedOrbit(time, objectnr), &xpos, &zpos, &dist_ret[objectnr], 1);
+
+        return bodyPotential(dist_ret[0], 0) + bodyPotential(dist_ret[1], 1);
+    }
+
+    glm::vec2 rpos = glm::vec2(xpos, zpos);
+
+    float dist0_ret = retardedDistance(time, rpos, 0);
+    float dist1_ret = retardedDistance(time, rpos, 1);
+
+    return bodyPotential(dist0_ret, 0) + bodyPotential(dist1_ret, 1);
+}
+
+void
+Binary::potentialBatch(float time, const float* xpos, const float* zpos, float* potential, int count,
+                       float* delta_t0, float* delta_t1, RetardedStats* stats) const
+{
+    std::vector<float> dist0_ret(count);
+    std::vector<float> dist1_ret(count);
+
+    // points outside of the far-field radius skip the Newton solver
+    std::vector<int> nearPoints, farPoints;
+    float farRadius2 = _farFieldRadius*_farFieldRadius;
+    for(int i = 0; i < count; ++i)
+    {
+        if(xpos[i]*xpos[i] + zpos[i]*zpos[i] >= farRadius2)
+            farPoints.push_back(i);
+        else
+            nearPoints.push_back(i);
+    }
+
+    if(farPoints.empty())
+    {
+        Clock::time_point start = Clock::now();
+        retardedDistanceBatch(retardedOrbit(time, 0), xpos, zpos, dist0_ret.data(), count, delta_t0, stats);
+        Clock::time_point middle = Clock::now();
+        retardedDistanceBatch(retardedOrbit(time, 1), xpos, zpos, dist1_ret.data(), count, delta_t1, stats);
+
+        if(stats)
+        {
+            stats->bodyMs[0] += std::chrono::duration<double, std::milli>(middle - start).count();
+            stats->bodyMs[1] += msSince(middle);
+        }
+    }
+    else
+    {
+        retardedDistances(time, nearPoints, false, xpos, zpos, dist0_ret.data(), dist1_ret.data(), delta_t0, delta_t1, stats);
+        retardedDistances(time, farPoints, true, xpos, zpos, dist0_ret.data(), dist1_ret.data(), delta_t0, delta_t1, stats);
+    }
+
+    bodyPotentials(dist0_ret.data(), dist1_ret.data(), potential, count);
+}
+
+template<bool WithHessian>
+void
+Binary::potentialDerivatives(float time, const float* xpos, const float* zpos, const float* delta_t0, const float* delta_t1,
+                             Dual<WithHessian>* result, int count) const
+{
+    const BinaryParameters& p = _parameters;
+    RetardedOrbit orbit[2] = {retardedOrbit(time, 0), retardedOrbit(time, 1)};
+
+    switch(p.model)
+    {
+    case eModelSoftened:
+        sumDerivatives(SoftenedProfile(_GM[0], p.R_N0), SoftenedProfile(_GM[1], p.R_N1),
+                       orbit, xpos, zpos, delta_t0, delta_t1, result, count);
+        break;
+    case eModelYukawa:
+        sumDerivatives(YukawaProfile(_GM[0], p.R_N0, p.yukawaLength), YukawaProfile(_GM[1], p.R_N1, p.yukawaLength),
+                       orbit, xpos, zpos, delta_t0, delta_t1, result, count);
+        break;
+    default:
+        sumDerivatives(NewtonianProfile(_GM[0], p.R_N0), NewtonianProfile(_GM[1], p.R_N1),
+                       orbit, xpos, zpos, delta_t0, delta_t1, result, count);
+    }
+}
+
+template void Binary::potentialDerivatives<false>(float, const float*, const float*, const float*, const float*,
+                                                  Dual<false>*, int) const;
+template void Binary::potentialDerivatives<true>(float, const float*, const float*, const float*, const float*,
+                                                 Dual<true>*, int) const;
+
+void
+Binary::retardedDistances(float time, const std::vector<int>& points, bool farPoints, const float* xpos, const float* zpos,
+                          float* dist0_ret, float* dist1_ret, float* delta_t0, float* delta_t1, RetardedStats* stats) const
+{
+    int count = points.size();
+    if(count == 0)
+        return;
+
+    // gather the points so the batch kernels see contiguous arrays
+    std::vector<float> x(count), z(count), distance(count), delta_t(count);
+    for(int k = 0; k < count; ++k)
+    {
+        x[k] = xpos[points[k]];
+        z[k] = zpos[points[k]];
+    }
+
+    float* dist_ret[2] = {dist0_ret, dist1_ret};
+    float* delta_t_io[2] = {delta_t0, delta_t1};
+    for(int objectnr = 0; objectnr < 2; ++objectnr)
+    {
+        Clock::time_point start = Clock::now();
+
+        if(delta_t_io[objectnr])
+            for(int k = 0; k < count; ++k)
+                delta_t[k] = delta_t_io[objectnr][points[k]];
+
+        float* guess = delta_t_io[objectnr] ? delta_t.data() : nullptr;
+        RetardedOrbit orbit = retardedOrbit(time, objectnr);
+        if(farPoints)
+            _farField[objectnr].distance(orbit, x.data(), z.data(), distance.data(), count, guess, stats);
+        else
+            retardedDistanceBatch(orbit, x.data(), z.data(), distance.data(), count, guess, stats);
+
+        for(int k = 0; k < count; ++k)
+            dist_ret[objectnr][points[k]] = distance[k];
+        if(delta_t_io[objectnr])
+            for(int k = 0; k < count; ++k)
+                delta_t_io[objectnr][points[k]] = delta_t[k];
+
+        if(stats)
+            stats->bodyMs[objectnr] += msSince(start);
+    }
+}
+
+void
+Binary::setFarFieldTolerance(float tolerance)
+{
+    _farFieldTolerance = tolerance;
+    updateFarField();
+}
+
+void
+Binary::updateFarField()
+{
+    // the error budget is split evenly between the bodies
+    _farField[0].configure(orbitRadius(0), _parameters.c_light_fraction, _GM[0], 0.5f*_farFieldTolerance);
+    _farField[1].configure(orbitRadius(1), _parameters.c_light_fraction, _GM[1], 0.5f*_farFieldTolerance);
+    _farFieldRadius = std::max(_farField[0].radius(), _farField[1].radius());
+}
@@ -0,0 +1,261 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include "physics/retardedbatch.h"
+#include "physics/dual.h"
+#include "physics/farfield.h"
+#include "physics/potentialmodel.h"
+
+#include <glm/vec2.hpp>
+
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief The BinaryParameters struct holds the physical parameters of the binary
+ *
+ * Both bodies are homogeneous spheres of the same density on circular
+ * orbits around their common centre of mass. The masses, the orbital
+ * radii and the speed of light follow from these values. The model
+ * selects the potential profile of the bodies (see potentialmodel.h).
+ */
+struct BinaryParameters
+{
+    float c_light_fraction = 0.8f;      /**< orbital velocity of the binary in units of c */
+    float omega = 4*M_PI_2/15.;         /**< orbital angular frequency */
+    float R_N0 = 0.02f;                 /**< radius of body 0 */
+    float R_N1 = 0.02f;                 /**< radius of body 1 */
+    float gravConst = 1.f;
+    float density = 500.f;
+    float separation = 0.1f;            /**< distance between the bodies */
+    ePotentialModel model = eModelNewtonian;
+    float yukawaLength = 0.3f;          /**< screening length of eModelYukawa */
+
+    bool operator==(const BinaryParameters& other) const
+    {
+        return c_light_fraction == other.c_light_fraction && omega == other.omega
+                && R_N0 == other.R_N0 && R_N1 == other.R_N1 && gravConst == other.gravConst
+                && density == other.density && separation == other.separation
+                && model == other.model && yukawaLength == other.yukawaLength;
+    }
+    bool operator!=(const BinaryParameters& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief The Binary class is the retarded Newtonian potential of a circular binary
+ *
+ * The potential at a point is the sum of the interior or exterior
+ * Newtonian potentials of both bodies, each taken at the distance to the
+ * position the body had when the signal left it (the retardation
+ * condition). Everything is a function of the parameters and of the
+ * time passed in, so a Binary can be evaluated by several threads at
+ * once as long as none of them calls a setter.
+ *
+ * This class neither uses OpenGL nor Qt, it is the physics library the
+ * renderer builds on and can be used on its own for headless runs.
+ */
+class Binary
+{
+public:
+    explicit Binary(const BinaryParameters& parameters = BinaryParameters());
+
+    /**
+     * @brief setParameters changes the physical parameters
+     */
+    void setParameters(const BinaryParameters& parameters);
+
+    /**
+     * @brief parameters Getter for the physical parameters
+     */
+    const BinaryParameters& parameters() const { return _parameters; }
+
+    /**
+     * @brief GM Getter for the mass of a body times the gravitational constant
+     */
+    float GM(int objectnr) const { return _GM[objectnr]; }
+
+    /**
+     * @brief bodyRadius Getter for the radius of a body
+     */
+    float bodyRadius(int objectnr) const { return objectnr == 0 ? _parameters.R_N0 : _parameters.R_N1; }
+
+    /**
+     * @brief isPointSymmetric Getter for whether the potential is symmetric under rotation by 180 degrees
+     *
+     * Bodies of equal radius have equal masses and are always diametrically
+     * opposite, the potential at (x, z) then equals the one at (-x, -z).
+     */
+    bool isPointSymmetric() const { return _parameters.R_N0 == _parameters.R_N1; }
+
+    /**
+     * @brief c_light Getter for the speed of light that gives the requested orbital velocity
+     */
+    float c_light() const { return _c_light; }
+
+    /**
+     * @brief orbitRadius Getter for the distance of a body from the centre of mass
+     */
+    float orbitRadius(int objectnr) const { return _rho[objectnr]; }
+
+    /**
+     * @brief trajectory Getter for the position of a body
+     * @param time the time
+     * @param objectnr the body, 0 or 1
+     * @return the position in the orbital (x, z) plane
+     */
+    glm::vec2 trajectory(float time, int objectnr) const;
+
+    /**
+     * @brief retardedOrbit Getter for the orbit of a body as seen by the batch solver
+     * @param time the time the phase is taken at
+     * @param objectnr the body, 0 or 1
+     *
+     * The iteration cap and the tolerance are the ones of setSolverIterations()
+     * and setSolverTolerance().
+     */
+    RetardedOrbit retardedOrbit(float time, int objectnr) const;
+
+    /**
+     * @brief helperfunction The retardation condition, zero for the retarded time delta_t
+     */
+    float helperfunction(float time, float delta_t, const glm::vec2& rpos, int objectnr) const;
+
+    /**
+     * @brief ddt_helpfunc Derivative of helperfunction() with respect to delta_t
+     */
+    float ddt_helpfunc(float time, float delta_t, const glm::vec2& rpos, int objectnr) const;
+
+    /**
+     * @brief retardedDistance solves the retardation condition for one point
+     * @param time the time
+     * @param rpos the point
+     * @param objectnr the body, 0 or 1
+     * @return the distance between the point and the retarded position of the body
+     *
+     * Newton inside the light-cone bracket with the same cap and tolerance
+     * as the batch solver, see retardedDistanceBatch().
+     */
+    float retardedDistance(float time, const glm::vec2& rpos, int objectnr) const;
+
+    /**
+     * @brief bodyPotential Potential of one body, in the profile of parameters().model
+     * @param dist_ret the retarded distance
+     * @param objectnr the body, 0 or 1
+     */
+    float bodyPotential(float dist_ret, int objectnr) const;
+
+    /**
+     * @brief bodyPotentials sums the potentials of both bodies for many points
+     * @param dist0_ret the retarded distances to body 0
+     * @param dist1_ret the retarded distances to body 1
+     * @param potential receives the potential
+     * @param count the number of points
+     *
+     * The model is dispatched once, the loop over the points is compiled
+     * for each profile of potentialmodel.h.
+     */
+    void bodyPotentials(const float* dist0_ret, const float* dist1_ret, float* potential, int count) const;
+
+    /**
+     * @brief potential Getter for the potential at one point
+     * @param time the time
+     * @param xpos the x coordinate of the point
+     * @param zpos the z coordinate of the point
+     *
+     * Uses the far-field expansion beyond farFieldRadius(), otherwise
+     * the scalar solver.
+     */
+    float potential(float time, float xpos, float zpos) const;
+
+    /**
+     * @brief potentialBatch Getter for the potential at many points
+     * @param time the time
+     * @param xpos the x coordinates of the points
+     * @param zpos the z coordinates of the points
+     * @param potential receives the potential
+     * @param count the number of points
+     * @param delta_t0 optional retarded times of body 0, see retardedDistanceBatch()
+     * @param delta_t1 optional retarded times of body 1
+     * @param stats optional, the work done is added to it
+     */
+    void potentialBatch(float time, const float* xpos, const float* zpos, float* potential, int count,
+                        float* delta_t0 = nullptr, float* delta_t1 = nullptr, RetardedStats* stats = nullptr) const;
+
+    /**
+     * @brief potentialDerivatives Getter for the potential and its derivatives in (x, z) at many points
+     * @param time the time
+     * @param xpos the x coordinates of the points
+     * @param zpos the z coordinates of the points
+     * @param delta_t0 the solved retarded times of body 0, e.g. from potentialBatch()
+     * @param delta_t1 the solved retarded times of body 1
+     * @param result receives value and gradient, and with WithHessian the Hessian
+     * @param count the number of points
+     *
+     * The retardation condition is refined from the solved delta_t by Newton
+     * steps in dual numbers. At the root the Newton step has a vanishing
+     * derivative in delta_t, so one step carries the exact gradient of
+     * delta_t and a second one the exact Hessian. The model is dispatched
+     * once per call like in bodyPotentials().
+     */
+    template<bool WithHessian>
+    void potentialDerivatives(float time, const float* xpos, const float* zpos, const float* delta_t0, const float* delta_t1,
+                              Dual<WithHessian>* result, int count) const;
+
+    /**
+     * @brief setFarFieldTolerance sets the allowed error of the far-field expansion
+     * @param tolerance allowed error of the potential of both bodies together, 0 disables the expansion
+     *
+     * Points far enough from the binary that the expansion is within the
+     * tolerance skip the Newton solver (see RetardedFarField).
+     */
+    void setFarFieldTolerance(float tolerance);
+
+    /**
+     * @brief getFarFieldTolerance Getter for the allowed error of the far-field expansion
+     */
+    float getFarFieldTolerance() const { return _farFieldTolerance; }
+
+    /**
+     * @brief setSolverIterations sets the hard cap on the retarded time solver steps per point
+     */
+    void setSolverIterations(int iterations) { _solverIterations = iterations; }
+
+    /**
+     * @brief getSolverIterations Getter for the cap on the solver steps per point
+     */
+    int getSolverIterations() const { return _solverIterations; }
+
+    /**
+     * @brief setSolverTolerance sets the residual of the retardation condition the solver stops at
+     */
+    void setSolverTolerance(float tolerance) { _solverTolerance = tolerance; }
+
+    /**
+     * @brief getSolverTolerance Getter for the residual the solver stops at
+     */
+    float getSolverTolerance() const { return _solverTolerance; }
+
+    /**
+     * @brief farFieldRadius Getter for the distance from the origin beyond which the expansion is used
+     */
+    float farFieldRadius() const { return _farFieldRadius; }
+
+private:
+    void retardedDistances(float time, const std::vector<int>& points, bool farPoints, const float* xpos, const float* zpos,
+                           float* dist0_ret, float* dist1_ret, float* delta_t0, float* delta_t1, RetardedStats* stats) const;
+    void updateFarField();
+
+    BinaryParameters _parameters;
+    float _GM[2];
+    float _rho[2];
+    float _c_light;
+
+    RetardedFarField _farField[2];  /**< far-field expansion of both bodies */
+    float _farFieldTolerance;
+    float _farFieldRadius;
+
+    int _solverIterations;
+    float _solverTolerance;
+};
+
+#endif // BINARY_H
@@ -0,0 +1,130 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+/**
+ * @brief The Dual struct is a forward-mode derivative in the two coordinates (x, z) of the orbital plane
+ *
+ * Dual<false> carries the value and the gradient, Dual<true> also the
+ * Hessian (xx, xz, zz). Every operation applies the chain rule, so any
+ * expression of Duals yields its exact derivatives along with its value.
+ */
+template<bool WithHessian>
+struct Dual
+{
+    float value;
+    glm::vec2 gradient;
+    glm::vec3 hessian;      /**< (d2/dx2, d2/dxdz, d2/dz2), zero for Dual<false> */
+
+    Dual(float value = 0.f) : value(value), gradient(0.f), hessian(0.f) {}
+
+    /**
+     * @brief variable Getter for the coordinate x (axis 0) or z (axis 1) at a value
+     */
+    static Dual variable(float value, int axis)
+    {
+        Dual result(value);
+        result.gradient[axis] = 1.f;
+        return result;
+    }
+
+    /**
+     * @brief chain applies a function with the derivatives df and d2f at value
+     */
+    Dual chain(float f, float df, float d2f) const
+    {
+        Dual result(f);
+        result.gradient = df*gradient;
+        if(WithHessian)
+            result.hessian = df*hessian + d2f*glm::vec3(gradient.x*gradient.x, gradient.x*gradient.y, gradient.y*gradient.y);
+        return result;
+    }
+};
+
+template<bool H> Dual<H> operator-(const Dual<H>& a) { return a.chain(-a.value, -1.f, 0.f); }
+
+template<bool H> Dual<H> operator+(const Dual<H>& a, const Dual<H>& b)
+{
+    Dual<H> result(a.value + b.value);
+    result.gradient = a.gradient + b.gradient;
+    result.hessian = a.hessian + b.hessian;
+    return result;
+}
+
+template<bool H> Dual<H> operator-(const Dual<H>& a, const Dual<H>& b) { return a + (-b); }
+
+template<bool H> Dual<H> operator*(const Dual<H>& a, const Dual<H>& b)
+{
+    Dual<H> result(a.value*b.value);
+    result.gradient = a.value*b.gradient + b.value*a.gradient;
+    if(H)
+        result.hessian = a.value*b.hessian + b.value*a.hessian
+                + glm::vec3(2.f*a.gradient.x*b.gradient.x,
+                            a.gradient.x*b.gradient.y + a.gradient.y*b.gradient.x,
+                            2.f*a.gradient.y*b.gradient.y);
+    return result;
+}
+
+template<bool H> Dual<H> reciprocal(const Dual<H>& a)
+{
+    float inv = 1.f/a.value;
+    return a.chain(inv, -inv*inv, 2.f*inv*inv*inv);
+}
+
+template<bool H> Dual<H> operator/(const Dual<H>& a, const Dual<H>& b) { return a*reciprocal(b); }
+
+// mixed with constants
+template<bool H> Dual<H> operator+(const Dual<H>& a, float b) { Dual<H> result = a; result.value += b; return result; }
+template<bool H> Dual<H> operator+(float a, const Dual<H>& b) { return b + a; }
+template<bool H> Dual<H> operator-(const Dual<H>& a, float b) { return a + (-b); }
+template<bool H> Dual<H> operator-(float a, const Dual<H>& b) { return (-b) + a; }
+template<bool H> Dual<H> operator*(const Dual<H>& a, float b) { return a.chain(a.value*b, b, 0.f); }
+template<bool H> Dual<H> operator*(float a, const Dual<H>& b) { return b*a; }
+template<bool H> Dual<H> operator/(const Dual<H>& a, float b) { return a*(1.f/b); }
+template<bool H> Dual<H> operator/(float a, const Dual<H>& b) { return a*reciprocal(b); }
+
+// comparisons only look at the value, branches are taken like for floats
+template<bool H> bool operator<(const Dual<H>& a, float b) { return a.value < b; }
+
+template<bool H> Dual<H> sqrt(const Dual<H>& a)
+{
+    // the derivative is cut off at zero, like the max(..., 0) in front of every sqrt of a distance
+    float root = std::sqrt(a.value);
+    if(!(root > 0.f))
+        return Dual<H>(0.f);
+    return a.chain(root, 0.5f/root, -0.25f/(root*a.value));
+}
+
+template<bool H> Dual<H> exp(const Dual<H>& a)
+{
+    float e = std::exp(a.value);
+    return a.chain(e, e, e);
+}
+
+template<bool H> Dual<H> sin(const Dual<H>& a)
+{
+    float s = std::sin(a.value);
+    return a.chain(s, std::cos(a.value), -s);
+}
+
+template<bool H> Dual<H> cos(const Dual<H>& a)
+{
+    float c = std::cos(a.value);
+    return a.chain(c, -std::sin(a.value), -c);
+}
+
+/**
+ * @brief sincos Getter for sin and cos of a Dual, with one evaluation of each
+ */
+template<bool H> void sincos(const Dual<H>& a, Dual<H>& s, Dual<H>& c)
+{
+    float sa = std::sin(a.value), ca = std::cos(a.value);
+    s = a.chain(sa, ca, -sa);
+    c = a.chain(ca, -sa, -ca);
+}
+
+#endif // DUAL_H
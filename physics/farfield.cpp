@@ -0,0 +1,178 @@
+#include "physics/farfield.h"
+#include "physics/farfield_kernel.h"
+#include "physics/isa.h"
+
+#include <cmath>
+#include <limits>
+
+#if defined(HAVE_AVX2)
+int farFieldDistanceAvx2(const RetardedFarField& field, const RetardedOrbit& orbit, const float* x, const float* z,
+                         float* distance, int count, float* delta_t, RetardedStats* stats);
+#endif
+#if defined(__SSE2__)
+int farFieldDistanceSse(const RetardedFarField& field, const RetardedOrbit& orbit, const float* x, const float* z,
+                        float* distance, int count, float* delta_t, RetardedStats* stats);
+#endif
+
+namespace {
+
+// rings used to measure the error, geometric from twice the orbital radius outwards
+const int errorRings = 48;
+const double ringFactor = 1.15;
+const int errorAngles = 256;
+
+/**
+ * @brief solveIncreasing finds the root of a strictly increasing function in [lo, hi]
+ *
+ * Newton steps that leave the bracket are replaced by bisection.
+ */
+template<class F, class DF>
+double solveIncreasing(F f, DF df, double lo, double hi)
+{
+    double x = 0.5*(lo + hi);
+    for(int i = 0; i < 100; ++i)
+    {
+        double value = f(x);
+        if(value > 0)
+            hi = x;
+        else
+            lo = x;
+
+        double next = x - value/df(x);
+        if(!(next > lo && next < hi))
+            next = 0.5*(lo + hi);
+        if(std::abs(next - x) < 1e-14)
+            return next;
+        x = next;
+    }
+    return x;
+}
+
+}
+
+RetardedFarField::RetardedFarField() :
+    _rho(0.f), _fraction(-1.f), _GM(0.f), _tolerance(0.f),
+    _radius(std::numeric_limits<float>::infinity())
+{
+}
+
+void
+RetardedFarField::configure(float rho, float c_light_fraction, float GM, float tolerance)
+{
+    if(rho == _rho && c_light_fraction == _fraction && GM == _GM && tolerance == _tolerance)
+        return;
+
+    bool newTables = (c_light_fraction != _fraction);
+
+    _rho = rho;
+    _fraction = c_light_fraction;
+    _GM = GM;
+    _tolerance = tolerance;
+    _radius = std::numeric_limits<float>::infinity();
+
+    // the retarded angle is only unique for orbits slower than light
+    if(tolerance <= 0.f || rho <= 0.f || c_light_fraction < 0.f || c_light_fraction >= 1.f)
+        return;
+
+    if(newTables)
+        buildTables();
+
+    // the error falls off like r^-4, so bisect for the innermost ring within the tolerance
+    int lo = 0, hi = errorRings;
+    while(lo < hi)
+    {
+        int ring = (lo + hi)/2;
+        if(maxError(2*rho*std::pow(ringFactor, ring)) > tolerance)
+            lo = ring + 1;
+        else
+            hi = ring;
+    }
+    if(hi < errorRings)
+        _radius = 2*rho*std::pow(ringFactor, hi);
+}
+
+void
+RetardedFarField::distance(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                           float* delta_t, RetardedStats* stats) const
+{
+    int done = 0;
+
+#if defined(HAVE_AVX2)
+    if(simdIsa() == eIsaAvx2)
+        done += farFieldDistanceAvx2(*this, orbit, x, z, distance, count, delta_t, stats);
+#endif
+#if defined(__SSE2__)
+    if(simdIsa() >= eIsaSse2)
+        done += farFieldDistanceSse(*this, orbit, x + done, z + done, distance + done, count - done,
+                                    delta_t ? delta_t + done : nullptr, stats);
+#endif
+
+    farFieldDistanceKernel<simd::ScalarFloat>(*this, orbit, x + done, z + done, distance + done, count - done,
+                                              delta_t ? delta_t + done : nullptr, stats);
+}
+
+void
+RetardedFarField::buildTables()
+{
+    const double f = _fraction;
+    const double spacing = 4*M_PI_2/nodes;
+
+    _table.resize(nodes + 1);
+
+    for(int i = 0; i <= nodes; ++i)
+    {
+        // leading order: alpha = u - f*cos(alpha)
+        double u = i*spacing;
+        double alpha = solveIncreasing([=](double a) { return a - u + f*std::cos(a); },
+                                       [=](double a) { return 1 - f*std::sin(a); },
+                                       u - f, u + f);
+        double s = std::sin(alpha);
+
+        _table[i].alpha = alpha;
+        _table[i].slope = spacing/(1 - f*s);
+        _table[i].correction = f*s*s/(2*(1 - f*s));
+        _table[i].padding = 0.f;
+    }
+}
+
+float
+RetardedFarField::maxError(float r) const
+{
+    // at phase 0 a ring covers every u the expansion can see at this radius
+    RetardedOrbit orbit;
+    orbit.rho = _rho;
+    orbit.phase = 0.f;
+    orbit.omega = 1.f;
+    orbit.c_light = 1.f;
+    orbit.c_light_fraction = _fraction;
+    orbit.iterations = 0;
+    orbit.tolerance = 0.f;
+
+    std::vector<float> x(errorAngles), z(errorAngles), approximation(errorAngles);
+    for(int m = 0; m < errorAngles; ++m)
+    {
+        double theta = 4*M_PI_2*(m + 0.37)/errorAngles;
+        x[m] = r*std::sin(theta);
+        z[m] = r*std::cos(theta);
+    }
+    distance(orbit, x.data(), z.data(), approximation.data(), errorAngles);
+
+    const double rho = _rho;
+    const double f = _fraction;
+    float error = 0.f;
+    for(int m = 0; m < errorAngles; ++m)
+    {
+        // exact: alpha = u + f*(D(alpha) - r)/rho in double precision
+        double rd = std::sqrt(double(x[m])*x[m] + double(z[m])*z[m]);
+        double u = std::atan2(double(x[m]), double(z[m])) + f*rd/rho;
+        auto D = [=](double a) { return std::sqrt(rd*rd - 2*rd*rho*std::cos(a) + rho*rho); };
+        double alpha = solveIncreasing([=](double a) { return a - u - f*(D(a) - rd)/rho; },
+                                       [=](double a) { return 1 - f*rd*std::sin(a)/D(a); },
+                                       u - f, u + f);
+
+        double exact = D(alpha);
+        error = std::max(error, float(_GM*std::abs(1/double(approximation[m]) - 1/exact)));
+    }
+
+    return error;
+}
@@ -0,0 +1,82 @@
+#ifndef FARFIELD_H
+#define FARFIELD_H
+
+#include "physics/retardedbatch.h"
+
+#include <vector>
+
+/**
+ * @brief The RetardedFarField class approximates the retarded distance far from the binary
+ *
+ * Far from the orbit the retardation condition of a body becomes
+ * alpha = u - f*cos(alpha) + O(rho/r), with alpha the angle between
+ * the point and the retarded body position, f the orbital velocity in
+ * units of c and u = theta - phase + f*r/rho. The leading order does
+ * not depend on r, so it is tabulated once per f together with the
+ * first order correction in rho/r. One Newton step on the exact
+ * condition then brings the error down to O((rho/r)^4).
+ *
+ * configure() measures the error against the exact solution on rings
+ * around the binary and sets radius() to the smallest ring from which
+ * on the potential of the body is within the tolerance.
+ */
+class RetardedFarField
+{
+public:
+    RetardedFarField();
+
+    /**
+     * @brief configure Rebuilds the tables and the radius if a parameter changed
+     * @param rho orbital radius of the body
+     * @param c_light_fraction orbital velocity in units of c
+     * @param GM mass of the body
+     * @param tolerance allowed error of the potential -GM/distance, 0 disables the far field
+     */
+    void configure(float rho, float c_light_fraction, float GM, float tolerance);
+
+    /**
+     * @brief radius Getter for the distance from the origin beyond which the expansion may be used
+     * @return the radius, infinity if the expansion is never accurate enough
+     */
+    float radius() const { return _radius; }
+
+    /**
+     * @brief distance evaluates the expansion for many points
+     *
+     * Same parameters as retardedDistanceBatch(), all points have to be
+     * outside of radius(). The retarded times are written to delta_t so
+     * the solver can warm start from them when a point falls back to it.
+     */
+    void distance(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                  float* delta_t = nullptr, RetardedStats* stats = nullptr) const;
+
+    /** @brief number of table intervals over one period of u */
+    static const int nodes = 1024;
+
+    /**
+     * @brief The Node struct holds the tables at one node, interleaved for the lookups
+     */
+    struct Node
+    {
+        float alpha;        /**< leading order alpha(u) */
+        float slope;        /**< d alpha/du times the node spacing */
+        float correction;   /**< coefficient of the first order in rho/r */
+        float padding;
+    };
+
+    const Node* table() const { return _table.data(); }
+
+private:
+    void buildTables();
+    float maxError(float r) const;
+
+    float _rho;
+    float _fraction;
+    float _GM;
+    float _tolerance;
+    float _radius;
+
+    std::vector<Node> _table;       /**< nodes + 1 entries over one period of u */
+};
+
+#endif // FARFIELD_H
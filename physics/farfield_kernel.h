@@ -0,0 +1,99 @@
+#ifndef FARFIELD_KERNEL_H
+#define FARFIELD_KERNEL_H
+
+#include "physics/farfield.h"
+#include "physics/simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief farFieldDistanceKernel evaluates the far-field expansion for V::width points per step
+ *
+ * Included by one translation unit per instruction set, see
+ * RetardedFarField::distance() for the parameters. Returns the number
+ * of points that have been processed, the caller evaluates the
+ * remaining count % V::width points.
+ */
+template<class V>
+int farFieldDistanceKernel(const RetardedFarField& field, const RetardedOrbit& orbit, const float* x, const float* z,
+                           float* distance, int count, float* delta_t_io, RetardedStats* stats)
+{
+    const int nodes = RetardedFarField::nodes;
+    const RetardedFarField::Node* table = field.table();
+
+    const V rho(orbit.rho);
+    const V invRho(1.f/orbit.rho);
+    const V fraction(orbit.c_light_fraction);
+    const V phase(orbit.phase);
+    const V nodesPerRadian(nodes/(4*M_PI_2));
+    const V invNodes(1.f/nodes);
+    const V period(4*M_PI_2);
+    const V toDeltaT(orbit.c_light_fraction/(orbit.rho*orbit.omega));
+    const V one(1.f);
+    const V zero(0.f);
+
+    int k = 0;
+    for(; k + V::width <= count; k += V::width)
+    {
+        V px = V::load(x + k);
+        V pz = V::load(z + k);
+        V r2 = px*px + pz*pz;
+        V r = sqrt(r2);
+
+        // bodies are at rho*(sin, cos) of their phase
+        V u = simd::atan2(px, pz) - phase + fraction*r*invRho;
+
+        V t = u*nodesPerRadian;
+        V node = floor(t);
+        V s = t - node;
+        V turns = floor(node*invNodes);
+        node = node - turns*V(float(nodes));
+
+        // table lookups lane by lane
+        float lanes[V::width], a0[V::width], a1[V::width], d0[V::width], d1[V::width], c0[V::width], c1[V::width];
+        node.store(lanes);
+        for(int l = 0; l < V::width; ++l)
+        {
+            int i = std::min(std::max(int(lanes[l]), 0), nodes - 1);
+            const RetardedFarField::Node& left = table[i];
+            const RetardedFarField::Node& right = table[i + 1];
+            a0[l] = left.alpha;
+            a1[l] = right.alpha;
+            d0[l] = left.slope;
+            d1[l] = right.slope;
+            c0[l] = left.correction;
+            c1[l] = right.correction;
+        }
+
+        // cubic Hermite interpolation of the leading order, linear for the correction
+        V s2 = s*s;
+        V s3 = s2*s;
+        V alpha = (V(2.f)*s3 - V(3.f)*s2 + one)*V::load(a0) + (s3 - V(2.f)*s2 + s)*V::load(d0)
+                + (V(3.f)*s2 - V(2.f)*s3)*V::load(a1) + (s3 - s2)*V::load(d1) + turns*period;
+        V correction = V::load(c0) + s*(V::load(c1) - V::load(c0));
+        alpha = alpha + rho/r*correction;
+
+        // one Newton step on alpha - u - f*(D(alpha) - r)/rho = 0
+        V sn, cs;
+        simd::sincos(alpha, sn, cs);
+        V dist = sqrt(max(r2 - V(2.f)*r*rho*cs + rho*rho, zero));
+        V h = alpha - u - fraction*(dist - r)*invRho;
+        V step = h/(one - fraction*r*sn/dist);
+
+        // cos(alpha - step) to second order in the small step
+        cs = cs*(one - V(0.5f)*step*step) + sn*step;
+        dist = sqrt(max(r2 - V(2.f)*r*rho*cs + rho*rho, zero));
+
+        dist.store(distance + k);
+        if(delta_t_io)
+            (dist*toDeltaT).store(delta_t_io + k);
+    }
+
+    if(stats)
+        stats->farPoints += k;
+
+    return k;
+}
+
+#endif // FARFIELD_KERNEL_H
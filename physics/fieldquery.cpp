@@ -0,0 +1,103 @@
+#include "physics/fieldquery.h"
+
+#include <algorithm>
+#include <numeric>
+
+FieldQuery::FieldQuery(const BinaryParameters& parameters, unsigned int threads) :
+    _binary(parameters), _pool(new ThreadPool(threads))
+{
+}
+
+void
+FieldQuery::setParameters(const BinaryParameters& parameters)
+{
+    _binary.setParameters(parameters);
+}
+
+void
+FieldQuery::evaluate(const float* x, const float* z, const float* t, int count, float* potential,
+                     float* gradientX, float* gradientZ, RetardedStats* stats)
+{
+    if(count <= 0)
+        return;
+
+    bool withGradient = gradientX || gradientZ;
+
+    // gather the points in the order of their times, a stable sort keeps queries at one time in place
+    _order.resize(count);
+    std::iota(_order.begin(), _order.end(), 0);
+    if(!std::is_sorted(t, t + count))
+        std::stable_sort(_order.begin(), _order.end(), [t](int a, int b) { return t[a] < t[b]; });
+
+    _x.resize(count);
+    _z.resize(count);
+    _t.resize(count);
+    _potential.resize(count);
+    _gradientX.resize(withGradient ? count : 0);
+    _gradientZ.resize(withGradient ? count : 0);
+    for(int k = 0; k < count; ++k)
+    {
+        _x[k] = x[_order[k]];
+        _z[k] = z[_order[k]];
+        _t[k] = t[_order[k]];
+    }
+
+    // runs of equal time, split into blocks for the pool
+    std::vector<Block> blocks;
+    for(int begin = 0; begin < count; )
+    {
+        int end = begin + 1;
+        while(end < count && end - begin < blockSize && _t[end] == _t[begin])
+            ++end;
+        blocks.push_back({begin, end});
+        begin = end;
+    }
+
+    _pool->parallelFor(0, blocks.size(), 1, [this, &blocks, withGradient, stats](int first, int last)
+    {
+        for(int b = first; b < last; ++b)
+            evaluateBlock(blocks[b], withGradient, stats);
+    });
+
+    for(int k = 0; k < count; ++k)
+    {
+        potential[_order[k]] = _potential[k];
+        if(gradientX)
+            gradientX[_order[k]] = _gradientX[k];
+        if(gradientZ)
+            gradientZ[_order[k]] = _gradientZ[k];
+    }
+}
+
+void
+FieldQuery::evaluateBlock(const Block& block, bool withGradient, RetardedStats* stats)
+{
+    int count = block.end - block.begin;
+    float time = _t[block.begin];
+    const float* x = &_x[block.begin];
+    const float* z = &_z[block.begin];
+
+    // no guesses, the points of a query are not related to each other
+    std::vector<float> delta_t0(count, -1.f), delta_t1(count, -1.f);
+    RetardedStats blockStats;
+
+    _binary.potentialBatch(time, x, z, &_potential[block.begin], count, delta_t0.data(), delta_t1.data(),
+                           stats ? &blockStats : nullptr);
+
+    if(withGradient)
+    {
+        std::vector<Dual<false>> derivatives(count);
+        _binary.potentialDerivatives(time, x, z, delta_t0.data(), delta_t1.data(), derivatives.data(), count);
+        for(int k = 0; k < count; ++k)
+        {
+            _gradientX[block.begin + k] = derivatives[k].gradient.x;
+            _gradientZ[block.begin + k] = derivatives[k].gradient.y;
+        }
+    }
+
+    if(stats)
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        *stats += blockStats;
+    }
+}
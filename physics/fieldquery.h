@@ -0,0 +1,83 @@
+#ifndef FIELDQUERY_H
+#define FIELDQUERY_H
+
+#include "physics/binary.h"
+#include "util/threadpool.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief The FieldQuery class samples the potential of a binary at arbitrary points and times
+ *
+ * The points are passed as structure of arrays. The batch solver handles
+ * one orbital phase at a time, so the points are grouped by time (sorted
+ * if they are not already) and every group is split into blocks that are
+ * evaluated on a thread pool with the vectorized solver. The gradient
+ * comes from Binary::potentialDerivatives().
+ *
+ * A FieldQuery may be used from one thread at a time, the results of
+ * evaluate() do not depend on the number of threads.
+ */
+class FieldQuery
+{
+public:
+    /**
+     * @brief FieldQuery constructor
+     * @param parameters the binary to sample
+     * @param threads the number of worker threads (0 uses all cores but one)
+     */
+    explicit FieldQuery(const BinaryParameters& parameters = BinaryParameters(), unsigned int threads = 0);
+
+    /**
+     * @brief evaluate Getter for the potential and optionally its gradient at many points
+     * @param x the x coordinates of the points
+     * @param z the z coordinates of the points
+     * @param t the times of the points
+     * @param count the number of points
+     * @param potential receives the potential
+     * @param gradientX optional, receives the derivative of the potential in x
+     * @param gradientZ optional, receives the derivative of the potential in z
+     * @param stats optional, the solver work is added to it
+     *
+     * Points with equal times are vectorized together, so queries of
+     * many points at a few times are the fast case.
+     */
+    void evaluate(const float* x, const float* z, const float* t, int count, float* potential,
+                  float* gradientX = nullptr, float* gradientZ = nullptr, RetardedStats* stats = nullptr);
+
+    /**
+     * @brief setParameters sets the binary to sample
+     */
+    void setParameters(const BinaryParameters& parameters);
+
+    /**
+     * @brief binary Getter for the sampled binary, e.g. to set its far-field tolerance
+     */
+    Binary& binary() { return _binary; }
+
+private:
+    /**
+     * @brief The Block struct is a range of points with the same time
+     */
+    struct Block
+    {
+        int begin;
+        int end;
+    };
+
+    void evaluateBlock(const Block& block, bool withGradient, RetardedStats* stats);
+
+    static const int blockSize = 1024;  /**< points per task of the pool */
+
+    Binary _binary;
+    std::unique_ptr<ThreadPool> _pool;
+    std::mutex _statsMutex;
+
+    // the points sorted by time and the results in that order
+    std::vector<int> _order;
+    std::vector<float> _x, _z, _t, _potential, _gradientX, _gradientZ;
+};
+
+#endif // FIELDQUERY_H
@@ -0,0 +1,52 @@
+#ifndef ISA_H
+#define ISA_H
+
+/**
+ * @brief The eIsa enum lists the instruction sets of the batch kernels
+ */
+enum eIsa
+{
+    eIsaScalar,
+    eIsaSse2,
+    eIsaAvx2
+};
+
+/**
+ * @brief simdIsa Getter for the best instruction set of this CPU
+ * @return the instruction set, detected once at the first call
+ *
+ * AVX2 is only reported if the AVX2 translation units have been
+ * compiled (HAVE_AVX2, see CMakeLists.txt).
+ */
+inline eIsa simdIsa()
+{
+    static const eIsa detected = []()
+    {
+#if defined(HAVE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+        if(__builtin_cpu_supports("avx2"))
+            return eIsaAvx2;
+#endif
+#if defined(__SSE2__)
+        return eIsaSse2;
+#else
+        return eIsaScalar;
+#endif
+    }();
+    return detected;
+}
+
+/**
+ * @brief simdIsaName Getter for the name of an instruction set
+ * @return "avx2", "sse2" or "scalar"
+ */
+inline const char* simdIsaName(eIsa isa)
+{
+    switch(isa)
+    {
+    case eIsaAvx2: return "avx2";
+    case eIsaSse2: return "sse2";
+    default:       return "scalar";
+    }
+}
+
+#endif // ISA_H
@@ -0,0 +1,114 @@
+#ifndef POTENTIALMODEL_H
+#define POTENTIALMODEL_H
+
+#include <cmath>
+
+/**
+ * @brief The ePotentialModel enum selects the potential profile of the bodies
+ */
+enum ePotentialModel
+{
+    eModelNewtonian = 0,    /**< homogeneous sphere, harmonic inside and -GM/r outside */
+    eModelSoftened,         /**< Plummer softened point mass */
+    eModelYukawa,           /**< screened sphere, -GM exp(-r/lambda)/r outside */
+    eModelCount
+};
+
+/**
+ * @brief potentialModelName Getter for the name of a potential model
+ */
+inline const char*
+potentialModelName(ePotentialModel model)
+{
+    switch(model)
+    {
+    case eModelSoftened: return "softened";
+    case eModelYukawa: return "yukawa";
+    default: return "newtonian";
+    }
+}
+
+/*
+ * The profiles are the potential of one body as a function of its retarded
+ * distance. They are policies for Binary::potentialBatch(): every constant
+ * is derived once in the constructor, operator() is inlined into the loop
+ * over the points, which is instantiated once per profile. operator()
+ * also takes Dual distances (see dual.h) for the derivatives of the potential.
+ */
+
+/**
+ * @brief The NewtonianProfile struct is the potential of a homogeneous sphere
+ */
+struct NewtonianProfile
+{
+    float radius;
+    float GM;
+    float interiorScale;    /**< GM/(2 R^3) */
+    float interiorOffset;   /**< -3 GM/(2 R) */
+
+    NewtonianProfile(float GM, float radius) :
+        radius(radius), GM(GM),
+        interiorScale(0.5f*GM/(radius*radius*radius)), interiorOffset(-1.5f*GM/radius)
+    {
+    }
+
+    template<class T>
+    T operator()(const T& distance) const
+    {
+        return distance < radius ? interiorScale*distance*distance + interiorOffset : -GM/distance;
+    }
+};
+
+/**
+ * @brief The SoftenedProfile struct is a Plummer sphere with the radius of the body as softening length
+ */
+struct SoftenedProfile
+{
+    float GM;
+    float softening2;       /**< squared softening length */
+
+    SoftenedProfile(float GM, float radius) :
+        GM(GM), softening2(radius*radius)
+    {
+    }
+
+    template<class T>
+    T operator()(const T& distance) const
+    {
+        using std::sqrt;
+        return -GM/sqrt(distance*distance + softening2);
+    }
+};
+
+/**
+ * @brief The YukawaProfile struct is a homogeneous sphere whose field is screened beyond its surface
+ *
+ * Inside the body the Newtonian profile is scaled by exp(-R/lambda), so the
+ * potential is continuous at the surface.
+ */
+struct YukawaProfile
+{
+    float radius;
+    float GM;
+    float invLength;        /**< 1/lambda */
+    float interiorScale;
+    float interiorOffset;
+
+    YukawaProfile(float GM, float radius, float length) :
+        radius(radius), GM(GM), invLength(1.f/length)
+    {
+        float screening = std::exp(-radius/length);
+        interiorScale = 0.5f*GM*screening/(radius*radius*radius);
+        interiorOffset = -1.5f*GM*screening/radius;
+    }
+
+    template<class T>
+    T operator()(const T& distance) const
+    {
+        using std::exp;
+        return distance < radius ? interiorScale*distance*distance + interiorOffset
+                                 : -GM*exp(-distance*invLength)/distance;
+    }
+};
+
+#endif // POTENTIALMODEL_H
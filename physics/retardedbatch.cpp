@@ -0,0 +1,44 @@
+#include "physics/retardedbatch.h"
+#include "physics/retardedbatch_kernel.h"
+#include "physics/isa.h"
+
+#if defined(HAVE_AVX2)
+int retardedDistanceAvx2(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                         float* delta_t, RetardedStats* stats);
+#endif
+#if defined(__SSE2__)
+int retardedDistanceSse(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                        float* delta_t, RetardedStats* stats);
+#endif
+
+int RetardedStats::residualBin(float residual)
+{
+    int bin = 0;
+    for(float edge = 1e-9f; bin < residualBins - 1 && !(residual < edge); edge *= 10.f)
+        ++bin;
+    return bin;
+}
+
+void retardedDistanceBatch(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                           float* delta_t, RetardedStats* stats)
+{
+    int done = 0;
+
+#if defined(HAVE_AVX2)
+    if(simdIsa() == eIsaAvx2)
+        done += retardedDistanceAvx2(orbit, x, z, distance, count, delta_t, stats);
+#endif
+#if defined(__SSE2__)
+    if(simdIsa() >= eIsaSse2)
+        done += retardedDistanceSse(orbit, x + done, z + done, distance + done, count - done,
+                                    delta_t ? delta_t + done : nullptr, stats);
+#endif
+
+    retardedDistanceKernel<simd::ScalarFloat>(orbit, x + done, z + done, distance + done, count - done,
+                                              delta_t ? delta_t + done : nullptr, stats);
+}
+
+const char* retardedBatchIsa()
+{
+    return simdIsaName(simdIsa());
+}
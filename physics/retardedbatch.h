@@ -0,0 +1,114 @@
+#ifndef RETARDEDBATCH_H
+#define RETARDEDBATCH_H
+
+/**
+ * @brief The RetardedOrbit struct describes one body on its circular orbit
+ *
+ * The body is at rho*(sin(phase), cos(phase)) at the current time and
+ * moves with the angular frequency omega. This is everything the
+ * retarded time solver needs to know about the binary.
+ */
+struct RetardedOrbit
+{
+    float rho;              /**< orbital radius of the body */
+    float phase;            /**< orbital phase at the current time */
+    float omega;            /**< orbital angular frequency */
+    float c_light;          /**< speed of light */
+    float c_light_fraction; /**< orbital velocity of the binary in units of c */
+    int iterations;         /**< hard cap on the solver steps per point */
+    float tolerance;        /**< the solver stops once the residual of the retardation condition is below it */
+};
+
+/**
+ * @brief The RetardedStats struct counts the work of the retarded time solver
+ *
+ * Besides the totals it keeps a histogram of the steps each point took
+ * and one of the residual each point ended with, by decade.
+ */
+struct RetardedStats
+{
+    static const int iterationBins = 17;    /**< 0 to 15 steps, the last bin counts 16 or more */
+    static const int residualBins = 8;      /**< below 1e-9, one bin per decade, the last bin counts 1e-3 or more */
+
+    long long points = 0;       /**< number of solved points */
+    long long newtonSteps = 0;  /**< solver steps over all points, Newton and bisection */
+    long long warmStarts = 0;   /**< points that started from their previous delta_t */
+    long long bisections = 0;   /**< steps that left the bracket and bisected instead */
+    long long capped = 0;       /**< points that hit the iteration cap above the tolerance */
+    long long farPoints = 0;    /**< points taken by the far-field expansion instead of the solver */
+    double bodyMs[2] = {0., 0.};/**< CPU time spent on each body, measured by Binary */
+    long long iterationHistogram[iterationBins] = {};
+    long long residualHistogram[residualBins] = {};
+
+    /**
+     * @brief residualBin Getter for the bin of residualHistogram that counts a residual
+     *
+     * Out of line, the kernels are compiled per instruction set and an
+     * inline copy from the AVX2 one could be picked for all of them.
+     */
+    static int residualBin(float residual);
+
+    /**
+     * @brief maxIterations Getter for the most steps any point took, the last bin counts as iterationBins - 1
+     */
+    int maxIterations() const
+    {
+        for(int bin = iterationBins - 1; bin > 0; --bin)
+            if(iterationHistogram[bin] > 0)
+                return bin;
+        return 0;
+    }
+
+    RetardedStats& operator+=(const RetardedStats& other)
+    {
+        points += other.points;
+        newtonSteps += other.newtonSteps;
+        warmStarts += other.warmStarts;
+        bisections += other.bisections;
+        capped += other.capped;
+        farPoints += other.farPoints;
+        bodyMs[0] += other.bodyMs[0];
+        bodyMs[1] += other.bodyMs[1];
+        for(int bin = 0; bin < iterationBins; ++bin)
+            iterationHistogram[bin] += other.iterationHistogram[bin];
+        for(int bin = 0; bin < residualBins; ++bin)
+            residualHistogram[bin] += other.residualHistogram[bin];
+        return *this;
+    }
+};
+
+/**
+ * @brief retardedDistanceBatch solves the retardation condition for many points
+ * @param orbit the orbit of the body
+ * @param x the x coordinates of the points
+ * @param z the z coordinates of the points
+ * @param distance receives the distances between the points and the retarded body positions
+ * @param count the number of points
+ * @param delta_t optional retarded times: a value >= 0 is used as initial guess, the solution is written back
+ * @param stats optional, the work done is added to it
+ *
+ * The retarded distance lies between |r - rho| and r + rho, where r is
+ * the distance of the point from the origin, so the root of the
+ * retardation condition is bracketed by the corresponding delta_t and
+ * the condition is strictly decreasing in between. Newton runs inside
+ * this bracket and shrinks it with every step, a step that would leave
+ * it bisects instead. A lane stops once its residual is within
+ * orbit.tolerance or after orbit.iterations steps, so no point costs
+ * more than orbit.iterations + 1 evaluations. A guess inside the bracket
+ * is used as the start point, otherwise the light travel time to the
+ * current position of the body.
+ *
+ * The points are processed 8 (AVX2) or 4 (SSE) at a time, lanes that are
+ * done are masked out until the whole vector is. The instruction set is
+ * chosen at runtime, remaining points are solved by the scalar path.
+ */
+void retardedDistanceBatch(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                           float* delta_t = nullptr, RetardedStats* stats = nullptr);
+
+/**
+ * @brief retardedBatchIsa Getter for the instruction set used by retardedDistanceBatch()
+ * @return "avx2", "sse2" or "scalar"
+ */
+const char* retardedBatchIsa();
+
+#endif // RETARDEDBATCH_H
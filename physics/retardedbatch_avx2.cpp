@@ -0,0 +1,34 @@
+// compiled with -mavx2 if the compiler supports it (see CMakeLists.txt)
+#include "physics/retardedbatch.h"
+#include "physics/farfield.h"
+
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// The kernels and the SIMD wrappers are inline, a weak copy of them built
+// with AVX2 must not replace the one of the scalar and SSE2 paths, so they
+// get internal linkage in this file.
+namespace {
+#include "physics/retardedbatch_kernel.h"
+#include "physics/farfield_kernel.h"
+}
+
+#if defined(__AVX2__)
+int retardedDistanceAvx2(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                         float* delta_t, RetardedStats* stats)
+{
+    return retardedDistanceKernel<simd::AvxFloat>(orbit, x, z, distance, count, delta_t, stats);
+}
+
+int farFieldDistanceAvx2(const RetardedFarField& field, const RetardedOrbit& orbit, const float* x, const float* z,
+                         float* distance, int count, float* delta_t, RetardedStats* stats)
+{
+    return farFieldDistanceKernel<simd::AvxFloat>(field, orbit, x, z, distance, count, delta_t, stats);
+}
+#endif
@@ -0,0 +1,135 @@
+#ifndef RETARDEDBATCH_KERNEL_H
+#define RETARDEDBATCH_KERNEL_H
+
+#include "physics/retardedbatch.h"
+#include "physics/simd.h"
+
+#include <algorithm>
+
+/**
+ * @brief retardedDistanceKernel solves the retardation condition for V::width points per step
+ *
+ * Included by one translation unit per instruction set, see retardedbatch.cpp
+ * and retardedDistanceBatch() for the parameters.
+ * Returns the number of points that have been processed, the caller
+ * solves the remaining count % V::width points.
+ */
+template<class V>
+int retardedDistanceKernel(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                           float* delta_t_io, RetardedStats* stats)
+{
+    // the C functions, the inline std:: overloads for float would be shared across the instruction sets
+    const float sinPhase = sinf(orbit.phase);
+    const float cosPhase = cosf(orbit.phase);
+
+    const V rho(orbit.rho);
+    const V omega(orbit.omega);
+    const V phase(orbit.phase);
+    const V fraction(orbit.c_light_fraction);
+    const V rhoOmega(orbit.rho*orbit.omega);
+    // the condition vanishes where delta_t is toDeltaT times the distance
+    const V toDeltaT(orbit.c_light_fraction/(orbit.rho*orbit.omega));
+    const V tolerance(orbit.tolerance);
+    const V tiny(1e-20f);
+    const V half(.5f);
+    const V one(1.f);
+    const V zero(0.f);
+
+    V steps = zero, bisections = zero, warmStarts = zero;
+
+    int k = 0;
+    for(; k + V::width <= count; k += V::width)
+    {
+        V px = V::load(x + k);
+        V pz = V::load(z + k);
+        V r2 = px*px + pz*pz + rho*rho;
+
+        // the light-cone bracket of the retarded time
+        V r = sqrt(px*px + pz*pz);
+        V lo = abs(r - rho)*toDeltaT;
+        V hi = (r + rho)*toDeltaT;
+
+        // the light travel time to the current position lies inside the bracket
+        V dx = px - V(orbit.rho*sinPhase);
+        V dz = pz - V(orbit.rho*cosPhase);
+        V delta_t = sqrt(dx*dx + dz*dz)*toDeltaT;
+
+        if(delta_t_io)
+        {
+            // NaN, negative or stale guesses outside the bracket are not used
+            V guess = V::load(delta_t_io + k);
+            typename V::Mask warm = V::andMask(lo <= guess, guess <= hi);
+            delta_t = V::select(warm, guess, delta_t);
+            warmStarts = warmStarts + V::select(warm, one, zero);
+        }
+
+        V laneSteps = zero;
+        V s, c, dist, h;
+        typename V::Mask stepping = V::allTrue();
+        for(int i = 0; ; ++i)
+        {
+            simd::sincos(phase - omega*delta_t, s, c);
+            dist = sqrt(max(r2 - V(2.f)*rho*(px*s + pz*c), zero));
+            h = fraction*dist - rhoOmega*delta_t;
+
+            stepping = V::andNot(stepping, abs(h) <= tolerance);
+            if(i == orbit.iterations || !V::any(stepping))
+                break;
+
+            // the condition decreases in delta_t, a positive residual means the root lies above
+            typename V::Mask below = (zero < h);
+            lo = V::select(V::andMask(stepping, below), delta_t, lo);
+            hi = V::select(V::andNot(stepping, below), delta_t, hi);
+
+            // Newton steps that leave the bracket (or divide by zero) bisect instead
+            V ddt = fraction*rhoOmega*(px*c - pz*s)/max(dist, tiny) - rhoOmega;
+            V next = delta_t - h/ddt;
+            typename V::Mask inside = V::andMask(lo < next, next < hi);
+            next = V::select(inside, next, half*(lo + hi));
+
+            delta_t = V::select(stepping, next, delta_t);
+            bisections = bisections + V::select(V::andNot(stepping, inside), one, zero);
+            laneSteps = laneSteps + V::select(stepping, one, zero);
+        }
+
+        dist.store(distance + k);
+        if(delta_t_io)
+            delta_t.store(delta_t_io + k);
+        steps = steps + laneSteps;
+
+        if(stats)
+        {
+            float laneCounts[V::width], laneResiduals[V::width];
+            laneSteps.store(laneCounts);
+            abs(h).store(laneResiduals);
+            for(int l = 0; l < V::width; ++l)
+            {
+                int bin = std::min(int(laneCounts[l]), RetardedStats::iterationBins - 1);
+                ++stats->iterationHistogram[bin];
+                ++stats->residualHistogram[RetardedStats::residualBin(laneResiduals[l])];
+                if(!(laneResiduals[l] <= orbit.tolerance))
+                    ++stats->capped;
+            }
+        }
+    }
+
+    if(stats)
+    {
+        float lanes[3][V::width];
+        steps.store(lanes[0]);
+        warmStarts.store(lanes[1]);
+        bisections.store(lanes[2]);
+
+        stats->points += k;
+        for(int l = 0; l < V::width; ++l)
+        {
+            stats->newtonSteps += (long long)(lanes[0][l]);
+            stats->warmStarts += (long long)(lanes[1][l]);
+            stats->bisections += (long long)(lanes[2][l]);
+        }
+    }
+
+    return k;
+}
+
+#endif // RETARDEDBATCH_KERNEL_H
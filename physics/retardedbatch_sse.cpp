@@ -0,0 +1,16 @@
+#include "physics/retardedbatch_kernel.h"
+#include "physics/farfield_kernel.h"
+
+#if defined(__SSE2__)
+int retardedDistanceSse(const RetardedOrbit& orbit, const float* x, const float* z, float* distance, int count,
+                        float* delta_t, RetardedStats* stats)
+{
+    return retardedDistanceKernel<simd::SseFloat>(orbit, x, z, distance, count, delta_t, stats);
+}
+
+int farFieldDistanceSse(const RetardedFarField& field, const RetardedOrbit& orbit, const float* x, const float* z,
+                        float* distance, int count, float* delta_t, RetardedStats* stats)
+{
+    return farFieldDistanceKernel<simd::SseFloat>(field, orbit, x, z, distance, count, delta_t, stats);
+}
+#endif
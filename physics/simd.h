@@ -0,0 +1,229 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Thin wrappers around one SIMD register of floats.
+ *
+ * All wrappers share the same interface, so kernels can be written once
+ * as templates over the wrapper type and instantiated per instruction set.
+ * A wrapper is only available if the translation unit is compiled for its
+ * instruction set (e.g. AvxFloat needs -mavx2).
+ */
+namespace simd {
+
+/**
+ * @brief The ScalarFloat struct is the fallback with a width of one
+ */
+struct ScalarFloat
+{
+    static const int width = 1;
+    typedef bool Mask;
+
+    float v;
+
+    ScalarFloat() {}
+    ScalarFloat(float a) : v(a) {}
+
+    static ScalarFloat load(const float* p) { return ScalarFloat(*p); }
+    void store(float* p) const { *p = v; }
+
+    friend ScalarFloat operator+(ScalarFloat a, ScalarFloat b) { return a.v + b.v; }
+    friend ScalarFloat operator-(ScalarFloat a, ScalarFloat b) { return a.v - b.v; }
+    friend ScalarFloat operator*(ScalarFloat a, ScalarFloat b) { return a.v * b.v; }
+    friend ScalarFloat operator/(ScalarFloat a, ScalarFloat b) { return a.v / b.v; }
+    friend ScalarFloat operator-(ScalarFloat a) { return -a.v; }
+
+    friend ScalarFloat sqrt(ScalarFloat a) { return std::sqrt(a.v); }
+    friend ScalarFloat abs(ScalarFloat a) { return std::fabs(a.v); }
+    friend ScalarFloat max(ScalarFloat a, ScalarFloat b) { return a.v > b.v ? a.v : b.v; }
+    friend ScalarFloat min(ScalarFloat a, ScalarFloat b) { return a.v < b.v ? a.v : b.v; }
+    friend ScalarFloat floor(ScalarFloat a) { return std::floor(a.v); }
+    friend ScalarFloat round(ScalarFloat a) { return std::nearbyint(a.v); }
+
+    friend Mask operator<(ScalarFloat a, ScalarFloat b) { return a.v < b.v; }
+    friend Mask operator<=(ScalarFloat a, ScalarFloat b) { return a.v <= b.v; }
+    friend Mask operator>(ScalarFloat a, ScalarFloat b) { return a.v > b.v; }
+    friend Mask operator==(ScalarFloat a, ScalarFloat b) { return a.v == b.v; }
+
+    static Mask allTrue() { return true; }
+    static Mask andNot(Mask a, Mask b) { return a && !b; }
+    static Mask orMask(Mask a, Mask b) { return a || b; }
+    static Mask andMask(Mask a, Mask b) { return a && b; }
+    static bool any(Mask m) { return m; }
+    static ScalarFloat select(Mask m, ScalarFloat a, ScalarFloat b) { return m ? a : b; }
+};
+
+#if defined(__SSE2__)
+/**
+ * @brief The SseFloat struct holds four floats
+ */
+struct SseFloat
+{
+    static const int width = 4;
+    typedef __m128 Mask;
+
+    __m128 v;
+
+    SseFloat() {}
+    SseFloat(__m128 a) : v(a) {}
+    SseFloat(float a) : v(_mm_set1_ps(a)) {}
+
+    static SseFloat load(const float* p) { return _mm_loadu_ps(p); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend SseFloat operator+(SseFloat a, SseFloat b) { return _mm_add_ps(a.v, b.v); }
+    friend SseFloat operator-(SseFloat a, SseFloat b) { return _mm_sub_ps(a.v, b.v); }
+    friend SseFloat operator*(SseFloat a, SseFloat b) { return _mm_mul_ps(a.v, b.v); }
+    friend SseFloat operator/(SseFloat a, SseFloat b) { return _mm_div_ps(a.v, b.v); }
+    friend SseFloat operator-(SseFloat a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.f)); }
+
+    friend SseFloat sqrt(SseFloat a) { return _mm_sqrt_ps(a.v); }
+    friend SseFloat abs(SseFloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+    friend SseFloat max(SseFloat a, SseFloat b) { return _mm_max_ps(a.v, b.v); }
+    friend SseFloat min(SseFloat a, SseFloat b) { return _mm_min_ps(a.v, b.v); }
+    friend SseFloat round(SseFloat a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)); }
+    friend SseFloat floor(SseFloat a)
+    {
+        // SSE2 has no floor, correct the truncated value for negative inputs
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.f)));
+    }
+
+    friend Mask operator<(SseFloat a, SseFloat b) { return _mm_cmplt_ps(a.v, b.v); }
+    friend Mask operator<=(SseFloat a, SseFloat b) { return _mm_cmple_ps(a.v, b.v); }
+    friend Mask operator>(SseFloat a, SseFloat b) { return _mm_cmpgt_ps(a.v, b.v); }
+    friend Mask operator==(SseFloat a, SseFloat b) { return _mm_cmpeq_ps(a.v, b.v); }
+
+    static Mask allTrue() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    static Mask andNot(Mask a, Mask b) { return _mm_andnot_ps(b, a); }
+    static Mask orMask(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static Mask andMask(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static bool any(Mask m) { return _mm_movemask_ps(m) != 0; }
+    static SseFloat select(Mask m, SseFloat a, SseFloat b) { return _mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v)); }
+};
+#endif
+
+#if defined(__AVX2__)
+/**
+ * @brief The AvxFloat struct holds eight floats
+ */
+struct AvxFloat
+{
+    static const int width = 8;
+    typedef __m256 Mask;
+
+    __m256 v;
+
+    AvxFloat() {}
+    AvxFloat(__m256 a) : v(a) {}
+    AvxFloat(float a) : v(_mm256_set1_ps(a)) {}
+
+    static AvxFloat load(const float* p) { return _mm256_loadu_ps(p); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+    friend AvxFloat operator+(AvxFloat a, AvxFloat b) { return _mm256_add_ps(a.v, b.v); }
+    friend AvxFloat operator-(AvxFloat a, AvxFloat b) { return _mm256_sub_ps(a.v, b.v); }
+    friend AvxFloat operator*(AvxFloat a, AvxFloat b) { return _mm256_mul_ps(a.v, b.v); }
+    friend AvxFloat operator/(AvxFloat a, AvxFloat b) { return _mm256_div_ps(a.v, b.v); }
+    friend AvxFloat operator-(AvxFloat a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f)); }
+
+    friend AvxFloat sqrt(AvxFloat a) { return _mm256_sqrt_ps(a.v); }
+    friend AvxFloat abs(AvxFloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v); }
+    friend AvxFloat max(AvxFloat a, AvxFloat b) { return _mm256_max_ps(a.v, b.v); }
+    friend AvxFloat min(AvxFloat a, AvxFloat b) { return _mm256_min_ps(a.v, b.v); }
+    friend AvxFloat floor(AvxFloat a) { return _mm256_floor_ps(a.v); }
+    friend AvxFloat round(AvxFloat a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+    friend Mask operator<(AvxFloat a, AvxFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+    friend Mask operator<=(AvxFloat a, AvxFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+    friend Mask operator>(AvxFloat a, AvxFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+    friend Mask operator==(AvxFloat a, AvxFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+
+    static Mask allTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    static Mask andNot(Mask a, Mask b) { return _mm256_andnot_ps(b, a); }
+    static Mask orMask(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static Mask andMask(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static bool any(Mask m) { return _mm256_movemask_ps(m) != 0; }
+    static AvxFloat select(Mask m, AvxFloat a, AvxFloat b) { return _mm256_blendv_ps(b.v, a.v, m); }
+};
+#endif
+
+/**
+ * @brief sincos evaluates sine and cosine of all lanes at once
+ * @param x the angles in radians
+ * @param s the sines
+ * @param c the cosines
+ *
+ * Cephes style: the argument is reduced to [-pi/4, pi/4] and both
+ * minimax polynomials are evaluated, the quadrant decides which one
+ * is the sine and which one the cosine. The relative error is below
+ * 1e-7 for |x| < 8192.
+ */
+template<class V>
+inline void sincos(V x, V& s, V& c)
+{
+    V j = round(x*V(0.63661977236758134f)); // 2/pi
+
+    // extended precision modular arithmetic
+    V y = x - j*V(1.5703125f);
+    y = y - j*V(4.837512969970703125e-4f);
+    y = y - j*V(7.54978995489188216e-8f);
+
+    V z = y*y;
+    V sy = y + y*z*(V(-1.6666654611e-1f) + z*(V(8.3321608736e-3f) + z*V(-1.9515295891e-4f)));
+    V cy = V(1.f) - V(0.5f)*z + z*z*(V(4.166664568298827e-2f) + z*(V(-1.388731625493765e-3f) + z*V(2.443315711809948e-5f)));
+
+    // quadrant 0..3
+    V q = j - V(4.f)*floor(j*V(0.25f));
+
+    typename V::Mask swap = V::orMask(q == V(1.f), q == V(3.f));
+    typename V::Mask negSin = q > V(1.5f);
+    typename V::Mask negCos = V::orMask(q == V(1.f), q == V(2.f));
+
+    s = V::select(swap, cy, sy);
+    c = V::select(swap, sy, cy);
+    s = V::select(negSin, -s, s);
+    c = V::select(negCos, -c, c);
+}
+
+/**
+ * @brief atan2 evaluates the angle of the points (x, y) for all lanes at once
+ * @param y the y coordinates
+ * @param x the x coordinates
+ * @return the angles in [-pi, pi]
+ *
+ * Cephes style: the ratio of the smaller to the larger coordinate is
+ * reduced to [0, tan(pi/8)], the octant is restored afterwards. The
+ * absolute error is below 2e-7.
+ */
+template<class V>
+inline V atan2(V y, V x)
+{
+    V ax = abs(x);
+    V ay = abs(y);
+    V a = min(ax, ay)/max(max(ax, ay), V(1e-30f));
+
+    typename V::Mask reduce = a > V(0.41421356237309503f); // tan(pi/8)
+    V t = V::select(reduce, (a - V(1.f))/(a + V(1.f)), a);
+
+    V z = t*t;
+    V p = t + t*z*(V(-3.33329491539e-1f) + z*(V(1.99777106478e-1f) + z*(V(-1.38776856032e-1f) + z*V(8.05374449538e-2f))));
+    p = V::select(reduce, p + V(0.78539816339744831f), p);
+
+    p = V::select(ay > ax, V(1.5707963267948966f) - p, p);
+    p = V::select(x < V(0.f), V(3.1415926535897932f) - p, p);
+    return V::select(y < V(0.f), -p, p);
+}
+
+} // namespace simd
+
+#endif // SIMD_H
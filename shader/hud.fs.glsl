@@ -0,0 +1,13 @@
+#version 400
+
+out vec4 fcolor;
+
+smooth in vec2 st;
+smooth in vec4 vcolor;
+uniform sampler2D atlas;
+
+void main()
+{
+    // the atlas holds the coverage of the glyphs, the solid cell is fully covered
+    fcolor = vec4(vcolor.rgb, vcolor.a*texture(atlas, st).r);
+}
@@ -0,0 +1,18 @@
+#version 400
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+
+uniform vec2 viewport;
+
+smooth out vec2 st;
+smooth out vec4 vcolor;
+
+void main()
+{
+    // pixels from the top left corner to normalized device coordinates
+    gl_Position = vec4(2.0*position.x/viewport.x - 1.0, 1.0 - 2.0*position.y/viewport.y, 0.0, 1.0);
+    st = texCoord;
+    vcolor = color;
+}
@@ -4,7 +4,9 @@ out vec4 fcolor;
 
 smooth in vec2 st;
 smooth in vec3 normal;
+smooth in float curvature;
 uniform sampler2D texture;
+uniform bool curvatureColouring;
 
 in vec3 pos;
 
@@ -46,6 +48,14 @@ void main(void)
     vec4 texCol = texture2D(texture, st);
     vec3 color = (ambient+diffuse+spec);
 
+    // bowls (positive mean curvature) blue, domes red, on a log scale up to a curvature of 1000
+    if(curvatureColouring)
+    {
+        float strength = min(log(1.0 + abs(curvature))/log(1000.0), 1.0);
+        vec3 tint = curvature > 0.0 ? vec3(0.4, 0.6, 1.0) : vec3(1.0, 0.45, 0.3);
+        color *= mix(vec3(1.0), tint, 0.8*strength);
+    }
+
     float transparency = min(1.f, 4.f - 4.f*sqrt(pos.x*pos.x + pos.z*pos.z));
 
     fcolor = (texCol*vec4(color, transparency));
@@ -0,0 +1,56 @@
+#version 400
+
+layout(vertices = 4) out;
+
+uniform mat4 projection_matrix;
+uniform mat4 modelview_matrix;
+
+uniform vec2 viewport;          // size of the viewport in pixels
+uniform float pixelsPerSegment; // target screen space length of a triangle edge
+uniform float wellGain;         // extra refinement at the surface of a star
+uniform vec2 starPos[2];        // current positions of the stars (unscaled)
+uniform float starRadius[2];
+uniform float scalefactor;
+
+in vec2 patchpos[];
+out vec2 tcpos[];
+
+vec2 screen(vec2 p)
+{
+    vec4 clip = projection_matrix * modelview_matrix * vec4(p.x, 0, p.y, 1);
+    return 0.5*viewport*clip.xy/max(clip.w, 1e-3);
+}
+
+// depends only on the edge, so neighbouring patches agree and there are no cracks
+float edgeLevel(vec2 a, vec2 b)
+{
+    float level = length(screen(a) - screen(b))/pixelsPerSegment;
+
+    // refine towards the potential wells, the curvature grows with 1/d^3
+    vec2 m = 0.5*(a + b)/scalefactor;
+    float well = 1.0;
+    for(int k = 0; k < 2; ++k)
+    {
+        float d = max(distance(m, starPos[k]), starRadius[k]);
+        well = max(well, 1.0 + wellGain*pow(starRadius[k]/d, 1.5));
+    }
+
+    return clamp(level*well, 1.0, 64.0);
+}
+
+void main(void)
+{
+    tcpos[gl_InvocationID] = patchpos[gl_InvocationID];
+
+    if(gl_InvocationID == 0)
+    {
+        // corners: 0 = (x0, z0), 1 = (x1, z0), 2 = (x1, z1), 3 = (x0, z1)
+        gl_TessLevelOuter[0] = edgeLevel(patchpos[0], patchpos[3]);
+        gl_TessLevelOuter[1] = edgeLevel(patchpos[0], patchpos[1]);
+        gl_TessLevelOuter[2] = edgeLevel(patchpos[1], patchpos[2]);
+        gl_TessLevelOuter[3] = edgeLevel(patchpos[3], patchpos[2]);
+
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
@@ -0,0 +1,110 @@
+#version 400
+
+// u runs along x and v along z, so cw in (u, v) is ccw seen from above like the CPU mesh
+layout(quads, fractional_even_spacing, cw) in;
+
+uniform mat4 projection_matrix;
+uniform mat4 modelview_matrix;
+uniform float scalefactor;
+
+// the binary, see Binary::helperfunction() and retardedDistanceBatch()
+uniform float phase[2];         // orbital phase of the bodies at the current time
+uniform float rho[2];           // orbital radius of the bodies
+uniform float GM[2];
+uniform float starRadius[2];
+uniform float omega;
+uniform float c_light;
+uniform float c_light_fraction;
+uniform int potentialModel;     // ePotentialModel, see potentialmodel.h
+uniform float yukawaLength;
+uniform int solverIterations;   // hard cap on the solver steps
+uniform float solverTolerance;  // residual the solver stops at
+
+in vec2 tcpos[];
+
+smooth out vec2 st;
+smooth out vec3 normal;
+smooth out float curvature;     // not computed on this path
+out vec3 pos;
+
+float distanceAt(vec2 p, int body, float delta_t)
+{
+    float phi = phase[body] - omega*delta_t;
+    return sqrt(max(dot(p, p) + rho[body]*rho[body] - 2*rho[body]*(p.x*sin(phi) + p.y*cos(phi)), 0.0));
+}
+
+// Newton solve of the retardation condition inside the light-cone bracket, as on the CPU
+float retardedDistance(vec2 p, int body)
+{
+    float rhoOmega = rho[body]*omega;
+    float toDeltaT = c_light_fraction/rhoOmega;
+    float r = length(p);
+    float lo = abs(r - rho[body])*toDeltaT;
+    float hi = (r + rho[body])*toDeltaT;
+
+    vec2 r0 = rho[body]*vec2(sin(phase[body]), cos(phase[body]));
+    float delta_t = length(p - r0)*toDeltaT;
+
+    for(int i = 0; i < solverIterations; ++i)
+    {
+        float phi = phase[body] - omega*delta_t;
+        float dist = distanceAt(p, body, delta_t);
+        float h = c_light_fraction*dist - rhoOmega*delta_t;
+        if(abs(h) <= solverTolerance)
+            break;
+
+        if(h > 0.0)
+            lo = delta_t;
+        else
+            hi = delta_t;
+
+        float ddt = c_light_fraction*rhoOmega*(p.x*cos(phi) - p.y*sin(phi))/max(dist, 1e-20) - rhoOmega;
+        float next = delta_t - h/ddt;
+        delta_t = (next > lo && next < hi) ? next : 0.5*(lo + hi);
+    }
+
+    return distanceAt(p, body, delta_t);
+}
+
+float potential(vec2 p)
+{
+    float result = 0.0;
+    for(int k = 0; k < 2; ++k)
+    {
+        float d = retardedDistance(p, k);
+        float R = starRadius[k];
+        if(potentialModel == 1)
+            result += -GM[k]/sqrt(d*d + R*R);
+        else if(potentialModel == 2)
+            result += (d < R) ? exp(-R/yukawaLength)*(0.5*GM[k]*d*d/(R*R*R) - 1.5*GM[k]/R) : -GM[k]*exp(-d/yukawaLength)/d;
+        else
+            result += (d < R) ? 0.5*GM[k]*d*d/(R*R*R) - 1.5*GM[k]/R : -GM[k]/d;
+    }
+    return result;
+}
+
+void main(void)
+{
+    vec2 u = gl_TessCoord.xy;
+    vec2 p = mix(mix(tcpos[0], tcpos[1], u.x), mix(tcpos[3], tcpos[2], u.x), u.y)/scalefactor;
+
+    // normals from forward differences
+    const float eps = 5e-4;
+    float h = potential(p);
+    float dhdx = (potential(p + vec2(eps, 0)) - h)/eps;
+    float dhdz = (potential(p + vec2(0, eps)) - h)/eps;
+
+    vec3 vpos = scalefactor*vec3(p.x, h, p.y);
+
+    // calculate position in model view projection space
+    gl_Position = projection_matrix * modelview_matrix * vec4(vpos, 1);
+
+    // Texture coordinates
+    st = 0.5*(p + 1.0);
+
+    // normals
+    normal = normalize(vec3(-dhdx, 1, -dhdz));
+
+    pos=vpos;
+    curvature = 0.0;
+}
@@ -5,19 +5,43 @@ uniform mat4 modelview_matrix;
 
 
 // get position from vertex array object
-layout(location = 0) in vec3 vpos;
+// (xz and texture coordinates are static, height and normals are streamed)
+layout(location = 0) in vec2 gridpos;
 layout(location = 1) in vec3 vertex_normals;
 layout(location = 2) in vec2 texCoords;
+layout(location = 3) in float height;
+layout(location = 4) in float vertex_curvature;
+
+// keyframed path: the rate of change of the height and the following keyframe,
+// the heights are blended by a cubic Hermite spline, blend 0 draws the first keyframe
+// (and everything the other paths stream) as it is
+layout(location = 5) in float height_rate;
+layout(location = 6) in vec3 vertex_normals1;
+layout(location = 7) in float height1;
+layout(location = 8) in float vertex_curvature1;
+layout(location = 9) in float height_rate1;
+
+uniform float blend;
+uniform float keyframeInterval;
 
 // send color to fragment shader
 //out vec3 vcolor;
 
 smooth out vec2 st;
 smooth out vec3 normal;
+smooth out float curvature;
 out vec3 pos;
 
 void main(void)
 {
+    float s = blend;
+    float s2 = s*s;
+    float s3 = s2*s;
+    float h = (2*s3 - 3*s2 + 1)*height + (3*s2 - 2*s3)*height1
+            + keyframeInterval*((s3 - 2*s2 + s)*height_rate + (s3 - s2)*height_rate1);
+
+    vec3 vpos = vec3(gridpos.x, h, gridpos.y);
+
     // calculate position in model view projection space
     gl_Position = projection_matrix * modelview_matrix * vec4(vpos, 1);
 
@@ -25,7 +49,8 @@ void main(void)
     st = texCoords;
 
     // normals
-    normal = vertex_normals;
+    normal = normalize(mix(vertex_normals, vertex_normals1, s));
+    curvature = mix(vertex_curvature, vertex_curvature1, s);
 
     pos=vpos;
 }
@@ -0,0 +1,56 @@
+#version 400
+
+uniform mat4 projection_matrix;
+uniform mat4 modelview_matrix;
+
+// potential at time 0 in co-rotating polar coordinates (s: angle, t: radius)
+uniform sampler2D field;
+uniform float phase;        // orbital phase at the current time
+uniform float fieldRadius;  // radius covered by the field
+uniform float spacing;      // grid spacing, used for the normals
+uniform float scalefactor;
+
+// get position from vertex array object
+layout(location = 0) in vec2 gridpos;
+layout(location = 2) in vec2 texCoords;
+
+smooth out vec2 st;
+smooth out vec3 normal;
+smooth out float curvature;     // not computed on this path
+out vec3 pos;
+
+const float PI = 3.14159265359;
+
+// the field rotates rigidly with the binary
+float potential(vec2 p)
+{
+    ivec2 size = textureSize(field, 0);
+    float angle = atan(p.x, p.y) - phase;
+    float r = length(p)/fieldRadius;
+
+    vec2 uv = vec2(angle/(2*PI) + 0.5/size.x, (r*(size.y - 1) + 0.5)/size.y);
+    return texture(field, uv).r;
+}
+
+void main(void)
+{
+    vec2 p = gridpos/scalefactor;
+
+    vec3 vpos = scalefactor*vec3(p.x, potential(p), p.y);
+
+    // normals from central differences of the field
+    float dhdx = (potential(p + vec2(spacing, 0)) - potential(p - vec2(spacing, 0)))/(2*spacing);
+    float dhdz = (potential(p + vec2(0, spacing)) - potential(p - vec2(0, spacing)))/(2*spacing);
+
+    // calculate position in model view projection space
+    gl_Position = projection_matrix * modelview_matrix * vec4(vpos, 1);
+
+    // Texture coordinates
+    st = texCoords;
+
+    // normals
+    normal = normalize(vec3(-dhdx, 1, -dhdz));
+
+    pos=vpos;
+    curvature = 0.0;
+}
@@ -0,0 +1,49 @@
+#version 400
+
+uniform mat4 projection_matrix;
+uniform mat4 modelview_matrix;
+
+// potential of every grid vertex
+uniform sampler2D heights;
+uniform float spacing;      // grid spacing, used for the normals
+
+// get position from vertex array object
+layout(location = 0) in vec2 gridpos;
+layout(location = 2) in vec2 texCoords;
+
+smooth out vec2 st;
+smooth out vec3 normal;
+smooth out float curvature;     // not computed on this path
+out vec3 pos;
+
+float height(ivec2 ij)
+{
+    ivec2 last = textureSize(heights, 0) - 1;
+    return texelFetch(heights, clamp(ij, ivec2(0), last), 0).r;
+}
+
+void main(void)
+{
+    ivec2 last = textureSize(heights, 0) - 1;
+    ivec2 ij = ivec2(round(texCoords*last));
+
+    vec3 vpos = vec3(gridpos.x, height(ij), gridpos.y);
+
+    // normals from differences of the neighbouring heights (one-sided at the border)
+    ivec2 lo = max(ij - 1, ivec2(0));
+    ivec2 hi = min(ij + 1, last);
+    float dhdx = (height(ivec2(hi.x, ij.y)) - height(ivec2(lo.x, ij.y)))/(spacing*(hi.x - lo.x));
+    float dhdz = (height(ivec2(ij.x, hi.y)) - height(ivec2(ij.x, lo.y)))/(spacing*(hi.y - lo.y));
+
+    // calculate position in model view projection space
+    gl_Position = projection_matrix * modelview_matrix * vec4(vpos, 1);
+
+    // Texture coordinates
+    st = texCoords;
+
+    // normals
+    normal = normalize(vec3(-dhdx, 1, -dhdz));
+
+    pos=vpos;
+    curvature = 0.0;
+}
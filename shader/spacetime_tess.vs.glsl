@@ -0,0 +1,11 @@
+#version 400
+
+// corners of the coarse patches, displaced in the evaluation shader
+layout(location = 0) in vec2 gridpos;
+
+out vec2 patchpos;
+
+void main(void)
+{
+    patchpos = gridpos;
+}
@@ -0,0 +1,26 @@
+#version 400
+
+out vec4 fcolor;
+
+smooth in vec2 st;
+uniform sampler2D scene;
+uniform float sharpness;    // 0 passes the bilinear upscale through
+
+void main()
+{
+    vec2 texel = 1.0/vec2(textureSize(scene, 0));
+
+    vec4 center = texture(scene, st);
+    vec3 north = texture(scene, st + vec2(0.0, texel.y)).rgb;
+    vec3 south = texture(scene, st - vec2(0.0, texel.y)).rgb;
+    vec3 east = texture(scene, st + vec2(texel.x, 0.0)).rgb;
+    vec3 west = texture(scene, st - vec2(texel.x, 0.0)).rgb;
+
+    // unsharp mask, limited to the range of the neighbourhood so edges do not ring
+    vec3 blur = 0.25*(north + south + east + west);
+    vec3 sharp = center.rgb + sharpness*(center.rgb - blur);
+    vec3 lo = min(center.rgb, min(min(north, south), min(east, west)));
+    vec3 hi = max(center.rgb, max(max(north, south), max(east, west)));
+
+    fcolor = vec4(clamp(sharp, lo, hi), center.a);
+}
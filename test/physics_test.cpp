@@ -0,0 +1,324 @@
+/*
+ * Headless checks of the physics library and the frame hand-over:
+ *  - fieldQuery:     FieldQuery::evaluate() against Binary::potential() for
+ *                    unsorted points at mixed times, with the gradient
+ *  - derivatives:    Binary::potentialDerivatives<true>() against central
+ *                    differences of the potential and of the gradient
+ *  - symmetry:       phi(x, z) = phi(-x, -z) while isPointSymmetric() holds
+ *  - farField:       the far-field expansion within its tolerance
+ *  - tripleBuffer:   a producer and a consumer thread on a TripleBuffer
+ *
+ * usage: cbmrnp_physics_test
+ *
+ * Prints every failed check and returns the number of failed tests.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "physics/binary.h"
+#include "physics/fieldquery.h"
+#include "util/triplebuffer.h"
+
+namespace {
+
+int failures = 0;   /**< failed checks of the current test */
+
+/**
+ * @brief check reports a failed comparison with its deviation
+ */
+void check(bool ok, const char* what, double deviation, double tolerance)
+{
+    if(ok)
+        return;
+
+    std::printf("  FAILED %s: deviation %g, tolerance %g\n", what, deviation, tolerance);
+    ++failures;
+}
+
+/**
+ * @brief relative Getter for the deviation of a value relative to a reference, absolute below 1
+ */
+double relative(double value, double reference)
+{
+    return std::abs(value - reference)/std::max(1., std::abs(reference));
+}
+
+/**
+ * @brief difference Getter for the fourth-order central difference of f at 0 with step h
+ */
+template<class F>
+auto difference(F f, double h)
+{
+    return (f(-2*h) - 8.*f(-h) + 8.*f(h) - f(2*h))/(12*h);
+}
+
+/**
+ * @brief randomPoints fills x and z with points in [-extent, extent]^2 outside a disc around the origin
+ */
+void randomPoints(std::mt19937& rng, int count, float extent, float minRadius, std::vector<float>& x, std::vector<float>& z)
+{
+    std::uniform_real_distribution<float> coordinate(-extent, extent);
+    x.clear();
+    z.clear();
+    while(int(x.size()) < count)
+    {
+        float px = coordinate(rng), pz = coordinate(rng);
+        if(px*px + pz*pz < minRadius*minRadius)
+            continue;
+        x.push_back(px);
+        z.push_back(pz);
+    }
+}
+
+void testFieldQuery()
+{
+    std::mt19937 rng(1);
+    const int count = 20000;
+
+    // points at a few times in random order, so the query has to sort and scatter them back
+    std::vector<float> x, z, t(count);
+    randomPoints(rng, count, 1.f, 0.f, x, z);
+    std::uniform_int_distribution<int> phase(0, 6);
+    for(float & time : t)
+        time = 0.25f*phase(rng);
+
+    FieldQuery query(BinaryParameters(), 3);
+    std::vector<float> potential(count), gradientX(count), gradientZ(count);
+    query.evaluate(x.data(), z.data(), t.data(), count, potential.data(), gradientX.data(), gradientZ.data());
+
+    // the single point solver, both with the far-field expansion of the same tolerance
+    Binary binary;
+    double potentialDeviation = 0., gradientDeviation = 0.;
+    for(int k = 0; k < count; ++k)
+    {
+        potentialDeviation = std::max(potentialDeviation, double(std::abs(potential[k] - binary.potential(t[k], x[k], z[k]))));
+
+        float delta_t0 = -1.f, delta_t1 = -1.f, value;
+        binary.potentialBatch(t[k], &x[k], &z[k], &value, 1, &delta_t0, &delta_t1);
+        Dual<false> derivative;
+        binary.potentialDerivatives(t[k], &x[k], &z[k], &delta_t0, &delta_t1, &derivative, 1);
+        gradientDeviation = std::max(gradientDeviation, double(std::abs(gradientX[k] - derivative.gradient.x)));
+        gradientDeviation = std::max(gradientDeviation, double(std::abs(gradientZ[k] - derivative.gradient.y)));
+    }
+    check(potentialDeviation <= 1e-5, "potential against Binary::potential()", potentialDeviation, 1e-5);
+    check(gradientDeviation <= 1e-4, "gradient against a single point", gradientDeviation, 1e-4);
+
+    // the results do not depend on the order of the points
+    std::vector<int> order(count);
+    for(int k = 0; k < count; ++k)
+        order[k] = k;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<float> sx(count), sz(count), st(count), shuffled(count);
+    for(int k = 0; k < count; ++k)
+    {
+        sx[k] = x[order[k]];
+        sz[k] = z[order[k]];
+        st[k] = t[order[k]];
+    }
+    query.evaluate(sx.data(), sz.data(), st.data(), count, shuffled.data());
+    double orderDeviation = 0.;
+    for(int k = 0; k < count; ++k)
+        orderDeviation = std::max(orderDeviation, double(std::abs(shuffled[k] - potential[order[k]])));
+    check(orderDeviation <= 1e-6, "potential of the shuffled points", orderDeviation, 1e-6);
+}
+
+void testDerivatives()
+{
+    std::mt19937 rng(2);
+    const int count = 200;
+    // the retarded field oscillates with a wavelength below 1, smaller steps drown in float noise
+    const float h = 1e-3f;
+
+    // outside the bodies, where the potential is smooth
+    std::vector<float> x, z;
+    randomPoints(rng, count, 1.f, 0.15f, x, z);
+
+    for(ePotentialModel model : {eModelNewtonian, eModelSoftened, eModelYukawa})
+    {
+        BinaryParameters parameters;
+        parameters.model = model;
+        Binary binary(parameters);
+        binary.setFarFieldTolerance(0.f);
+        float time = 1.3f;
+
+        auto derivatives = [&](float px, float pz, auto& result)
+        {
+            float delta_t0 = -1.f, delta_t1 = -1.f, value;
+            binary.potentialBatch(time, &px, &pz, &value, 1, &delta_t0, &delta_t1);
+            binary.potentialDerivatives(time, &px, &pz, &delta_t0, &delta_t1, &result, 1);
+            return value;
+        };
+
+        double valueDeviation = 0., gradientDeviation = 0., hessianDeviation = 0.;
+        for(int k = 0; k < count; ++k)
+        {
+            Dual<true> d;
+            float value = derivatives(x[k], z[k], d);
+            valueDeviation = std::max(valueDeviation, double(std::abs(d.value - value)));
+
+            // the gradient against differences of the potential, the Hessian against differences of the gradient
+            auto alongX = [&](double dx) { return double(binary.potential(time, x[k] + dx, z[k])); };
+            auto alongZ = [&](double dz) { return double(binary.potential(time, x[k], z[k] + dz)); };
+            auto gradientAlongX = [&](double dx) { Dual<false> g; derivatives(x[k] + dx, z[k], g); return glm::dvec2(g.gradient); };
+            auto gradientAlongZ = [&](double dz) { Dual<false> g; derivatives(x[k], z[k] + dz, g); return glm::dvec2(g.gradient); };
+            glm::dvec2 hessianX = difference(gradientAlongX, h);
+            glm::dvec2 hessianZ = difference(gradientAlongZ, h);
+
+            gradientDeviation = std::max({gradientDeviation, relative(d.gradient.x, difference(alongX, h)),
+                                          relative(d.gradient.y, difference(alongZ, h))});
+            hessianDeviation = std::max({hessianDeviation, relative(d.hessian.x, hessianX.x), relative(d.hessian.y, hessianX.y),
+                                         relative(d.hessian.y, hessianZ.x), relative(d.hessian.z, hessianZ.y)});
+        }
+
+        std::printf("  %s: value %g, gradient %g, hessian %g\n", potentialModelName(model),
+                    valueDeviation, gradientDeviation, hessianDeviation);
+        check(valueDeviation <= 1e-6, "value of the derivatives", valueDeviation, 1e-6);
+        check(gradientDeviation <= 5e-4, "gradient against central differences", gradientDeviation, 5e-4);
+        check(hessianDeviation <= 5e-3, "Hessian against central differences", hessianDeviation, 5e-3);
+    }
+}
+
+void testSymmetry()
+{
+    std::mt19937 rng(3);
+    std::vector<float> x, z;
+    randomPoints(rng, 2000, 1.f, 0.f, x, z);
+
+    Binary binary;
+    check(binary.isPointSymmetric(), "equal masses are point symmetric", 1., 0.);
+
+    double deviation = 0.;
+    for(float time : {0.f, 0.7f, 3.1f})
+        for(size_t k = 0; k < x.size(); ++k)
+            deviation = std::max(deviation, double(std::abs(binary.potential(time, x[k], z[k]) - binary.potential(time, -x[k], -z[k]))));
+    check(deviation <= 1e-6, "phi(x, z) = phi(-x, -z)", deviation, 1e-6);
+
+    BinaryParameters unequal;
+    unequal.R_N1 = 0.014f;
+    check(!Binary(unequal).isPointSymmetric(), "unequal masses are not point symmetric", 1., 0.);
+}
+
+void testFarField()
+{
+    // a grid reaching well beyond the far-field radius
+    const int side = 200;
+    const float extent = 4.f;
+    std::vector<float> x, z;
+    for(int j = 0; j <= side; ++j)
+        for(int i = 0; i <= side; ++i)
+        {
+            x.push_back(extent*(-1 + 2*float(i)/side));
+            z.push_back(extent*(-1 + 2*float(j)/side));
+        }
+    int count = x.size();
+
+    for(float tolerance : {1e-3f, 1e-4f, 1e-5f})
+    {
+        Binary exact, expanded;
+        exact.setFarFieldTolerance(0.f);
+        expanded.setFarFieldTolerance(tolerance);
+
+        std::vector<float> reference(count), potential(count);
+        RetardedStats stats;
+        float time = 2.2f;
+        exact.potentialBatch(time, x.data(), z.data(), reference.data(), count);
+        expanded.potentialBatch(time, x.data(), z.data(), potential.data(), count, nullptr, nullptr, &stats);
+
+        double deviation = 0.;
+        for(int k = 0; k < count; ++k)
+            deviation = std::max(deviation, double(std::abs(potential[k] - reference[k])));
+
+        std::printf("  tolerance %g: deviation %g, %lld of %d points in the far field\n",
+                    tolerance, deviation, stats.farPoints/2, count);
+        check(stats.farPoints > 0, "far-field expansion in use", 0., 0.);
+        check(deviation <= tolerance, "far-field error", deviation, tolerance);
+    }
+}
+
+void testTripleBuffer()
+{
+    // every value is a sequence number repeated over the whole buffer, a torn read mixes two of them
+    struct Value
+    {
+        std::vector<long long> data = std::vector<long long>(4096, -1);
+    };
+
+    TripleBuffer<Value> buffer;
+    const long long published = 200000;
+    std::atomic<bool> done(false);
+
+    std::thread producer([&]()
+    {
+        for(long long n = 0; n < published; ++n)
+        {
+            std::fill(buffer.back().data.begin(), buffer.back().data.end(), n);
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    long long last = -1, acquired = 0, torn = 0, backwards = 0;
+    for(;;)
+    {
+        bool finished = done;
+        if(buffer.acquire())
+        {
+            const std::vector<long long>& data = buffer.front().data;
+            long long n = data.front();
+            if(std::any_of(data.begin(), data.end(), [n](long long v) { return v != n; }))
+                ++torn;
+            if(n <= last)
+                ++backwards;
+            last = n;
+            ++acquired;
+        }
+        else if(finished)
+        {
+            break;
+        }
+    }
+    producer.join();
+
+    std::printf("  %lld of %lld values acquired\n", acquired, published);
+    check(torn == 0, "torn values", torn, 0.);
+    check(backwards == 0, "values acquired out of order", backwards, 0.);
+    check(last == published - 1, "last value acquired", published - 1 - last, 0.);
+}
+
+}
+
+int main()
+{
+    struct Test
+    {
+        const char* name;
+        void (*run)();
+    };
+    const Test tests[] = {
+        {"fieldQuery", testFieldQuery},
+        {"derivatives", testDerivatives},
+        {"symmetry", testSymmetry},
+        {"farField", testFarField},
+        {"tripleBuffer", testTripleBuffer},
+    };
+
+    int failed = 0;
+    for(const Test& test : tests)
+    {
+        failures = 0;
+        std::printf("%s\n", test.name);
+        test.run();
+        std::printf("%s: %s\n", test.name, failures ? "FAILED" : "passed");
+        failed += failures ? 1 : 0;
+    }
+
+    return failed;
+}
@@ -0,0 +1,141 @@
+#include "util/threadpool.h"
+#include "util/trace.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : _queued(0), _nextQueue(0), _stop(false)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    for(unsigned int i = 0; i < std::max(1u, threads); ++i)
+        _queues.push_back(std::unique_ptr<Queue>(new Queue));
+
+    for(unsigned int i = 0; i < threads; ++i)
+        _workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for(auto & worker : _workers)
+        worker.join();
+}
+
+unsigned int
+ThreadPool::size() const
+{
+    return _workers.size() + 1;
+}
+
+void
+ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body)
+{
+    if(end <= begin)
+        return;
+    grain = std::max(1, grain);
+
+    if(_workers.empty() || end - begin <= grain)
+    {
+        body(begin, end);
+        return;
+    }
+
+    std::atomic<int> remaining((end - begin + grain - 1)/grain);
+
+    for(int first = begin; first < end; first += grain)
+    {
+        int last = std::min(end, first + grain);
+        push([&body, &remaining, first, last]()
+        {
+            body(first, last);
+            --remaining;
+        });
+    }
+
+    // help with the work until all blocks of this call are done
+    std::function<void()> task;
+    unsigned int self = _nextQueue.load() % _queues.size();
+    while(remaining > 0)
+    {
+        if(popOrSteal(self, task))
+            task();
+        else
+            std::this_thread::yield();
+    }
+}
+
+void
+ThreadPool::push(std::function<void()> task)
+{
+    Queue& queue = *_queues[_nextQueue++ % _queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_queued;
+    }
+    _wake.notify_one();
+}
+
+bool
+ThreadPool::popOrSteal(unsigned int self, std::function<void()>& task)
+{
+    // own queue first (newest task, still warm in cache)
+    {
+        Queue& queue = *_queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --_queued;
+            return true;
+        }
+    }
+
+    // steal the oldest task of another queue
+    for(unsigned int k = 1; k < _queues.size(); ++k)
+    {
+        Queue& queue = *_queues[(self + k) % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --_queued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+ThreadPool::run(unsigned int self)
+{
+    Trace::setThreadName("pool worker " + std::to_string(self));
+
+    std::function<void()> task;
+    while(true)
+    {
+        if(popOrSteal(self, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this]() { return _stop || _queued > 0; });
+        if(_stop)
+            return;
+    }
+}
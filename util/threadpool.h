@@ -0,0 +1,73 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The ThreadPool class is a small work-stealing thread pool
+ *
+ * Every worker owns a task queue. Workers take tasks from the back of
+ * their own queue and steal from the front of the other queues when
+ * they run dry. The thread calling parallelFor() helps until all of
+ * its blocks are done, so a pool with zero workers runs serially.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief ThreadPool constructor
+     * @param threads the number of worker threads (0 uses all cores but one)
+     */
+    explicit ThreadPool(unsigned int threads = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief parallelFor splits [begin, end) into blocks and runs them on the pool
+     * @param begin the first index
+     * @param end one past the last index
+     * @param grain the number of indices per block
+     * @param body called as body(blockBegin, blockEnd) for every block
+     *
+     * Returns after all blocks have been processed.
+     */
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body);
+
+    /**
+     * @brief size Getter for the number of threads taking part in parallelFor()
+     * @return the number of workers plus the calling thread
+     */
+    unsigned int size() const;
+
+private:
+    struct Queue
+    {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues; /**< one queue per worker */
+    std::vector<std::thread> _workers;
+
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    std::atomic<int> _queued;   /**< number of tasks in all queues */
+    std::atomic<unsigned int> _nextQueue;
+    bool _stop;
+
+    void push(std::function<void()> task);
+    bool popOrSteal(unsigned int self, std::function<void()>& task);
+    void run(unsigned int self);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,145 @@
+#include "util/trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    int64_t begin;
+    int64_t end;
+};
+
+/**
+ * @brief The Track struct holds the events of one thread (or of the GPU)
+ *
+ * The mutex is only contended while the recording is written.
+ */
+struct Track
+{
+    int id;
+    std::string name;
+    std::mutex mutex;
+    std::vector<Event> events;
+};
+
+// tracks are never deleted, so a thread may still hold its track after the registry was cleared
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Track>> tracks;
+int64_t recordingBegin = 0;
+
+Track* newTrack(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    tracks.push_back(std::unique_ptr<Track>(new Track));
+    Track* track = tracks.back().get();
+    track->id = tracks.size();
+    track->name = name.empty() ? "thread " + std::to_string(track->id) : name;
+    return track;
+}
+
+Track& threadTrack()
+{
+    thread_local Track* track = newTrack("");
+    return *track;
+}
+
+Track& gpuTrack()
+{
+    static Track* track = newTrack("GPU");
+    return *track;
+}
+
+void append(Track& track, const char* name, int64_t beginNs, int64_t endNs)
+{
+    std::lock_guard<std::mutex> lock(track.mutex);
+    track.events.push_back({name, beginNs, endNs});
+}
+
+}
+
+std::atomic<bool> Trace::_recording(false);
+
+void
+Trace::start()
+{
+    gpuTrack();
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(auto & track : tracks)
+    {
+        std::lock_guard<std::mutex> trackLock(track->mutex);
+        track->events.clear();
+    }
+    recordingBegin = now();
+    _recording = true;
+}
+
+void
+Trace::stop()
+{
+    _recording = false;
+}
+
+bool
+Trace::write(const std::string& path)
+{
+    std::ofstream out(path);
+    if(!out)
+        return false;
+
+    // complete events ("X") with times in us, one track per thread
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(auto & track : tracks)
+    {
+        std::lock_guard<std::mutex> trackLock(track->mutex);
+
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << track->id << ", \"args\": {\"name\": \"" << track->name << "\"}}";
+        first = false;
+
+        for(const Event& event : track->events)
+        {
+            out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << track->id
+                << ", \"ts\": " << (event.begin - recordingBegin)/1e3
+                << ", \"dur\": " << (event.end - event.begin)/1e3 << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return bool(out);
+}
+
+int64_t
+Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+Trace::addEvent(const char* name, int64_t beginNs, int64_t endNs)
+{
+    append(threadTrack(), name, beginNs, endNs);
+}
+
+void
+Trace::addGpuEvent(const char* name, int64_t beginNs, int64_t endNs)
+{
+    append(gpuTrack(), name, beginNs, endNs);
+}
+
+void
+Trace::setThreadName(const std::string& name)
+{
+    Track& track = threadTrack();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    track.name = name;
+}
@@ -0,0 +1,103 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief The Trace class records timed zones of all threads for chrome://tracing
+ *
+ * Zones are opened with TRACE_SCOPE("name") and closed at the end of the
+ * scope. While no recording runs a zone costs one relaxed load, without
+ * HAVE_TRACE the macro expands to nothing. Every thread writes into its
+ * own buffer, so recording threads do not contend with each other.
+ * GPU times are added by GpuTrace on a track of their own.
+ *
+ * write() stores the recording in the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev open directly.
+ */
+class Trace
+{
+public:
+    /**
+     * @brief start discards the last recording and starts a new one
+     */
+    static void start();
+
+    /**
+     * @brief stop stops recording, zones that are still open are completed
+     */
+    static void stop();
+
+    /**
+     * @brief isRecording Getter for whether zones are recorded
+     */
+    static bool isRecording() { return _recording.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief write stores the recording as Chrome trace event JSON
+     * @param path the file to write
+     * @return false if the file could not be written
+     */
+    static bool write(const std::string& path);
+
+    /**
+     * @brief now Getter for the time of the trace clock in ns
+     */
+    static int64_t now();
+
+    /**
+     * @brief addEvent adds a completed zone to the track of the calling thread
+     * @param name the name, has to stay valid until the recording is written
+     * @param beginNs the begin on the trace clock
+     * @param endNs the end on the trace clock
+     */
+    static void addEvent(const char* name, int64_t beginNs, int64_t endNs);
+
+    /**
+     * @brief addGpuEvent adds a completed zone to the GPU track
+     *
+     * Same parameters as addEvent(), the times have to be converted to
+     * the trace clock.
+     */
+    static void addGpuEvent(const char* name, int64_t beginNs, int64_t endNs);
+
+    /**
+     * @brief setThreadName names the track of the calling thread
+     * @param name the name shown for the track
+     */
+    static void setThreadName(const std::string& name);
+
+    /**
+     * @brief The Zone class records the time from its construction to its destruction
+     */
+    class Zone
+    {
+    public:
+        explicit Zone(const char* name) :
+            _name(isRecording() ? name : nullptr), _begin(_name ? now() : 0) {}
+        ~Zone() { if(_name) addEvent(_name, _begin, now()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* _name;  /**< nullptr if the zone is not recorded */
+        int64_t _begin;
+    };
+
+private:
+    static std::atomic<bool> _recording;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef HAVE_TRACE
+#define TRACE_SCOPE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+#endif // TRACE_H
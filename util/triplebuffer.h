@@ -0,0 +1,75 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * @brief The TripleBuffer class hands the latest value from one producer to one consumer
+ *
+ * The producer fills back() and publishes it, the consumer picks up the
+ * most recently published value with acquire() and reads it through
+ * front(). The third buffer sits in between, so neither side ever waits
+ * for the other: the producer may publish several values between two
+ * acquires (only the last one is seen) and the consumer may read the
+ * same value several times.
+ *
+ * The only shared state is the index of the middle buffer together with
+ * a flag that marks it as not yet seen, exchanged atomically by both
+ * sides.
+ */
+template<class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : _middle(1), _back(0), _front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * @brief back Getter for the buffer the producer writes to
+     */
+    T& back() { return _buffers[_back]; }
+
+    /**
+     * @brief publish makes the back buffer the latest value
+     *
+     * Only called by the producer. The producer continues with the buffer
+     * that was in the middle, its content is an older value.
+     */
+    void publish()
+    {
+        _back = _middle.exchange(_back | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    /**
+     * @brief acquire picks up the latest published value
+     * @return true if front() changed since the last call
+     *
+     * Only called by the consumer.
+     */
+    bool acquire()
+    {
+        if(!(_middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    /**
+     * @brief front Getter for the buffer the consumer reads from
+     */
+    const T& front() const { return _buffers[_front]; }
+
+private:
+    static const unsigned int index = 3;    /**< bits of the buffer index */
+    static const unsigned int fresh = 4;    /**< set while the middle buffer has not been acquired */
+
+    T _buffers[3];
+    std::atomic<unsigned int> _middle;  /**< index of the middle buffer and the fresh flag */
+    unsigned int _back;                 /**< owned by the producer */
+    unsigned int _front;                /**< owned by the consumer */
+};
+
+#endif // TRIPLEBUFFER_H